@@ -0,0 +1,356 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SpamApi.h"
+#include "SpamDetector.hpp"
+#include "TestData.hpp"
+
+#define THRESHOLD 40
+#define SCORING_THREADS 4
+
+/**
+ *
+ * @param phrases
+ * @return the database file of the phrases
+ */
+std::string database(const std::vector<Phrase> &phrases)
+{
+    std::string database;
+    for (const Phrase &phrase : phrases)
+    {
+        database += phrase.text + "," + std::to_string(phrase.points) + "\n";
+    }
+    return database;
+}
+
+/**
+ * the score the command line gives the message
+ * @param database
+ * @param engine
+ * @param message
+ * @return
+ */
+SpamResult detectorScore(const std::string &database, const std::string &engine, const std::string &message)
+{
+    std::string msg;
+    SpamDetector detector(THRESHOLD, 0, msg);
+    detector.setEngine(engine);
+    std::istringstream stream(database);
+    detector.loadDataBase(stream);
+    bool spam = detector.scoreMessage(message.data(), message.size());
+    return SpamResult{detector.getBadPoints(), detector.getMatches(), spam};
+}
+
+/**
+ *
+ * @param dictionary
+ * @param message
+ * @param random picks the pieces
+ * @param pieces the borders of the pieces, random ones if empty
+ * @return the score of the message fed in pieces
+ */
+SpamResult streamScore(const SpamDictionary *dictionary, const std::string &message, std::mt19937 &random,
+                       const std::vector<size_t> &pieces)
+{
+    SpamResult result{-1, -1, -1};
+    SpamStream *stream = nullptr;
+    if (spamStreamOpen(dictionary, &stream) != SPAM_OK)
+    {
+        return result;
+    }
+    bool ok = true;
+    size_t begin = 0;
+    for (size_t piece = 0; begin < message.size(); ++piece)
+    {
+        size_t end = piece < pieces.size() ? pieces[piece] : begin + 1 + random() % 5000;
+        end = std::min(std::max(end, begin), message.size());
+        ok &= spamStreamFeed(stream, message.data() + begin, end - begin) == SPAM_OK;
+        begin = end;
+    }
+    ok &= spamStreamFinish(stream, &result) == SPAM_OK;
+    spamStreamFree(stream);
+    return ok ? result : SpamResult{-1, -1, -1};
+}
+
+/**
+ *
+ * @param name
+ * @param expected
+ * @param found
+ * @return true iff both are the same score
+ */
+bool same(const std::string &name, const SpamResult &expected, const SpamResult &found)
+{
+    if (found.score == expected.score && found.matches == expected.matches && found.spam == expected.spam)
+    {
+        return true;
+    }
+    std::cerr << name << ": scored " << found.score << " / " << found.matches << " / " << found.spam
+              << " instead of " << expected.score << " / " << expected.matches << " / " << expected.spam
+              << std::endl;
+    return false;
+}
+
+/**
+ * scores the messages with spamScore, with a stream and with SpamDetector::scoreMessage and compares them
+ * @param name
+ * @param phrases
+ * @param engine
+ * @param messages
+ * @param pieces borders to feed the stream at, random ones after them
+ * @param random
+ * @return true iff all three scored every message the same
+ */
+bool check(const std::string &name, const std::vector<Phrase> &phrases, const std::string &engine,
+           const std::vector<std::string> &messages, const std::vector<size_t> &pieces, std::mt19937 &random)
+{
+    std::string data = database(phrases);
+    SpamDictionary *dictionary = nullptr;
+    SpamStatus status = spamDictionaryCompile(data.data(), data.size(), THRESHOLD, engine.c_str(), &dictionary);
+    if (status != SPAM_OK)
+    {
+        std::cerr << name << ", " << engine << ": " << spamStatusMessage(status) << std::endl;
+        return false;
+    }
+    bool ok = true;
+    for (size_t i = 0; i < messages.size(); ++i)
+    {
+        std::string where = name + ", " + engine + ", message " + std::to_string(i);
+        SpamResult expected = detectorScore(data, engine, messages[i]);
+        SpamResult scored{-1, -1, -1};
+        ok &= spamScore(dictionary, messages[i].data(), messages[i].size(), &scored) == SPAM_OK;
+        ok &= same(where + ", spamScore", expected, scored);
+        ok &= same(where + ", stream", expected, streamScore(dictionary, messages[i], random, pieces));
+    }
+    spamDictionaryFree(dictionary);
+    return ok;
+}
+
+/**
+ * random dictionaries and messages, long enough to be scanned in several windows
+ * @param random
+ * @return true iff every way of scoring agrees
+ */
+bool checkRandom(std::mt19937 &random)
+{
+    std::vector<std::string> engines = MatcherFactory::engines();
+    engines.push_back(AUTO_ENGINE);
+    const std::vector<std::string> alphabets = {"ab", "aB c", "abcdefghijklmnopqrstuvwxyz .!"};
+    bool ok = true;
+    for (const std::string &alphabet : alphabets)
+    {
+        for (size_t count : {1, 10, 200})
+        {
+            std::vector<Phrase> phrases = TestData::dictionary(random, alphabet, count, 12);
+            std::vector<std::string> messages = {"", TestData::text(random, alphabet, 1),
+                                                 TestData::text(random, alphabet, 1000),
+                                                 TestData::text(random, alphabet, SCAN_WINDOW),
+                                                 TestData::text(random, alphabet, 3 * SCAN_WINDOW + random() % 1000)};
+            for (const std::string &engine : engines)
+            {
+                ok &= check(alphabet + ", " + std::to_string(count) + " phrases", phrases, engine, messages, {},
+                            random);
+            }
+        }
+    }
+    return ok;
+}
+
+/**
+ * one long phrase at and around the end of the first scan window, fed in pieces that end inside it
+ * @param random
+ * @return true iff every way of scoring agrees
+ */
+bool checkWindowBorder(std::mt19937 &random)
+{
+    const std::string phrase = "free money now";
+    std::vector<Phrase> phrases = {{phrase, 50, 1}, {"money", 3, 1}, {"y n", 1, 1}};
+    bool ok = true;
+    for (size_t at = SCAN_WINDOW - 2 * phrase.size(); at < SCAN_WINDOW + phrase.size(); ++at)
+    {
+        std::string message = TestData::text(random, "abc ", at) + phrase +
+                              TestData::text(random, "abc ", SCAN_WINDOW / 2);
+        // a border inside the phrase, and one at the window's end
+        std::vector<size_t> pieces = {at + 1 + random() % (phrase.size() - 1), SCAN_WINDOW + 2 * phrase.size()};
+        ok &= check("phrase at " + std::to_string(at), phrases, AUTO_ENGINE, {message}, pieces, random);
+    }
+    return ok;
+}
+
+/**
+ * an empty database, and every function with arguments it must refuse
+ * @return true iff every call returned the expected status
+ */
+bool checkErrors()
+{
+    bool ok = true;
+    auto expect = [&ok](const std::string &name, SpamStatus found, SpamStatus expected)
+    {
+        if (found != expected)
+        {
+            std::cerr << name << ": returned \"" << spamStatusMessage(found) << "\" instead of \""
+                      << spamStatusMessage(expected) << "\"" << std::endl;
+            ok = false;
+        }
+    };
+    SpamDictionary *dictionary = nullptr;
+    expect("no database", spamDictionaryCompile(nullptr, 0, 1, nullptr, &dictionary), SPAM_OK);
+    spamDictionaryFree(dictionary);
+    expect("empty database", spamDictionaryCompile("", 0, 1, nullptr, &dictionary), SPAM_OK);
+    SpamResult result{-1, -1, -1};
+    expect("score with an empty database", spamScore(dictionary, "free money", 10, &result), SPAM_OK);
+    ok &= same("empty database", SpamResult{0, 0, 0}, result);
+    ok &= same("empty database, stream", SpamResult{0, 0, 0}, [&]()
+    {
+        std::mt19937 random(36);
+        return streamScore(dictionary, "free money", random, {});
+    }());
+    expect("empty message", spamScore(dictionary, nullptr, 0, &result), SPAM_OK);
+
+    expect("no message", spamScore(dictionary, nullptr, 1, &result), SPAM_ERROR_ARGUMENT);
+    expect("no result", spamScore(dictionary, "a", 1, nullptr), SPAM_ERROR_ARGUMENT);
+    expect("no dictionary", spamScore(nullptr, "a", 1, &result), SPAM_ERROR_ARGUMENT);
+    expect("cache of no dictionary", spamDictionarySetCacheSize(nullptr, 1), SPAM_ERROR_ARGUMENT);
+    unsigned long hits;
+    expect("no misses", spamDictionaryCacheStats(dictionary, &hits, nullptr), SPAM_ERROR_ARGUMENT);
+    SpamStream *stream = nullptr;
+    expect("stream of no dictionary", spamStreamOpen(nullptr, &stream), SPAM_ERROR_ARGUMENT);
+    expect("no stream", spamStreamOpen(dictionary, nullptr), SPAM_ERROR_ARGUMENT);
+    expect("open a stream", spamStreamOpen(dictionary, &stream), SPAM_OK);
+    expect("no data", spamStreamFeed(stream, nullptr, 1), SPAM_ERROR_ARGUMENT);
+    expect("no stream result", spamStreamFinish(stream, nullptr), SPAM_ERROR_ARGUMENT);
+    expect("finish", spamStreamFinish(stream, &result), SPAM_OK);
+    expect("feed after finish", spamStreamFeed(stream, "a", 1), SPAM_ERROR_ARGUMENT);
+    spamStreamFree(stream);
+    spamDictionaryFree(dictionary);
+
+    const std::string valid = "free money,5\n";
+    expect("no dictionary pointer", spamDictionaryCompile(valid.data(), valid.size(), 1, nullptr, nullptr),
+           SPAM_ERROR_ARGUMENT);
+    expect("no database of some size", spamDictionaryCompile(nullptr, 1, 1, nullptr, &dictionary),
+           SPAM_ERROR_ARGUMENT);
+    for (double threshold : {0.0, -1.0, std::nan("")})
+    {
+        expect("threshold " + std::to_string(threshold),
+               spamDictionaryCompile(valid.data(), valid.size(), threshold, nullptr, &dictionary), SPAM_ERROR_ARGUMENT);
+    }
+    expect("unknown engine", spamDictionaryCompile(valid.data(), valid.size(), 1, "grep", &dictionary),
+           SPAM_ERROR_ARGUMENT);
+    expect("no path", spamDictionaryLoad(nullptr, 1, nullptr, &dictionary), SPAM_ERROR_ARGUMENT);
+    expect("missing file", spamDictionaryLoad("/nonexistent/bad_words.csv", 1, nullptr, &dictionary),
+           SPAM_ERROR_IO);
+    const std::vector<std::string> invalid = {"free money\n", "free money,5,6\n", "free money,five\n", ",5\n",
+                                              "free,\n", "\nfree money,5\n", "free money,99999999999999999999\n"};
+    for (const std::string &bad : invalid)
+    {
+        dictionary = nullptr;
+        expect("database \"" + bad + "\"", spamDictionaryCompile(bad.data(), bad.size(), 1, nullptr, &dictionary),
+               SPAM_ERROR_DATABASE);
+        if (dictionary != nullptr)
+        {
+            std::cerr << "a dictionary was returned for an invalid database" << std::endl;
+            spamDictionaryFree(dictionary);
+            ok = false;
+        }
+    }
+    for (int status = SPAM_OK; status <= SPAM_ERROR_INTERNAL; ++status)
+    {
+        ok &= std::strlen(spamStatusMessage((SpamStatus) status)) > 0;
+    }
+    return ok;
+}
+
+/**
+ * scores the same messages, many of them more than once, on several threads with one dictionary
+ * @param random
+ * @param cacheEntries 0 for no cache
+ * @return true iff every thread got the single threaded scores, and the cache counted every call
+ */
+bool checkThreads(std::mt19937 &random, size_t cacheEntries)
+{
+    std::string name = cacheEntries == 0 ? "threads without a cache" : "threads with a cache";
+    std::vector<Phrase> phrases = TestData::dictionary(random, "abc ", 60, 8);
+    std::string data = database(phrases);
+    SpamDictionary *dictionary = nullptr;
+    if (spamDictionaryCompile(data.data(), data.size(), THRESHOLD, nullptr, &dictionary) != SPAM_OK ||
+        spamDictionarySetCacheSize(dictionary, cacheEntries) != SPAM_OK)
+    {
+        std::cerr << name << ": the dictionary can't be made" << std::endl;
+        spamDictionaryFree(dictionary);
+        return false;
+    }
+    std::vector<std::string> messages;
+    std::vector<SpamResult> expected;
+    for (int i = 0; i < 50; ++i)
+    {
+        messages.push_back(TestData::text(random, "abc ", 1 + random() % 3000));
+        expected.push_back(detectorScore(data, AUTO_ENGINE, messages.back()));
+    }
+    const int calls = 2000;
+    std::vector<int> wrong(SCORING_THREADS, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < SCORING_THREADS; ++t)
+    {
+        threads.emplace_back([&, t]()
+                             {
+                                 std::mt19937 pick(t);
+                                 for (int call = 0; call < calls; ++call)
+                                 {
+                                     size_t i = pick() % messages.size();
+                                     SpamResult result{-1, -1, -1};
+                                     if (spamScore(dictionary, messages[i].data(), messages[i].size(), &result) !=
+                                         SPAM_OK || result.score != expected[i].score ||
+                                         result.matches != expected[i].matches || result.spam != expected[i].spam)
+                                     {
+                                         ++wrong[t];
+                                     }
+                                 }
+                             });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    bool ok = true;
+    for (int t = 0; t < SCORING_THREADS; ++t)
+    {
+        if (wrong[t] > 0)
+        {
+            std::cerr << name << ": thread " << t << " got " << wrong[t] << " wrong scores" << std::endl;
+            ok = false;
+        }
+    }
+    unsigned long hits = 0;
+    unsigned long misses = 0;
+    spamDictionaryCacheStats(dictionary, &hits, &misses);
+    bool counted = cacheEntries == 0 ? hits == 0 : hits > 0 && hits + misses == SCORING_THREADS * calls;
+    if (!counted)
+    {
+        std::cerr << name << ": " << hits << " hits, " << misses << " misses" << std::endl;
+        ok = false;
+    }
+    spamDictionaryFree(dictionary);
+    return ok;
+}
+
+/**
+ *
+ * @return
+ */
+int main()
+{
+    std::mt19937 random(36);
+    bool ok = true;
+    ok &= checkErrors();
+    ok &= checkRandom(random);
+    ok &= checkWindowBorder(random);
+    ok &= checkThreads(random, DEFAULT_CACHE_ENTRIES);
+    ok &= checkThreads(random, 0);
+    std::cout << (ok ? "passed" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,570 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define BATCH_IO_URING
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifndef BATCHREADER
+#define BATCHREADER
+
+#define DEFAULT_IN_FLIGHT 32
+// the ring gets twice as many entries, and io_uring refuses rings of more than 32768
+#define MAX_IN_FLIGHT 16384
+// the buffer of a file whose size fstat doesn't tell, doubled while it fills up
+#define READ_CHUNK 4096
+// room for every opcode in an IORING_REGISTER_PROBE answer
+#define IORING_PROBE_OPS 256
+#define CLOSE_TAG (~0ULL)
+
+/**
+ * Reads a list of files with up to inFlight reads in flight, and hands each file to a handler as soon as it was
+ * read, so reading the next files overlaps with handling this one.
+ * On linux the opens, reads and closes are submitted through io_uring, anywhere else (or when the kernel refuses
+ * io_uring, or is older than 5.6 and can't open, read or close through it) a pool of reader threads is used.
+ */
+class BatchReader
+{
+public:
+    /**
+     *
+     * @param paths the files to read
+     * @param inFlight the number of files read at once, at most MAX_IN_FLIGHT
+     */
+    BatchReader(const std::vector<std::string> &paths, unsigned int inFlight) : _paths(paths),
+                                                                                _inFlight(std::min(std::max(inFlight, 1u), (unsigned int) MAX_IN_FLIGHT))
+    {}
+
+    /**
+     * reads all the files, in completion order
+     * @tparam Handler callable as handler(size_t index, std::string &content, bool ok)
+     * @param handler called on this thread once for every path, ok is false if the file couldn't be read
+     */
+    template<typename Handler>
+    void run(Handler &handler)
+    {
+#ifdef BATCH_IO_URING
+        if (_runRing(handler))
+        {
+            return;
+        }
+#endif
+        _runThreads(handler);
+    }
+
+    /**
+     *
+     * @return true if the last run went through io_uring
+     */
+    bool usedRing() const
+    {
+        return _usedRing;
+    }
+
+private:
+    const std::vector<std::string> &_paths;
+    unsigned int _inFlight;
+    bool _usedRing = false;
+
+    /**
+     * the portable path - one reader thread per core pushes whole files to a queue that holds at most inFlight files
+     * @tparam Handler
+     * @param handler
+     */
+    template<typename Handler>
+    void _runThreads(Handler &handler)
+    {
+        struct Done
+        {
+            size_t index;
+            std::string content;
+            bool ok;
+        };
+        std::atomic<size_t> next(0);
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::condition_variable space;
+        std::deque<Done> done;
+
+        auto reader = [&]()
+        {
+            for (size_t i = next++; i < _paths.size(); i = next++)
+            {
+                Done d{i, std::string(), true};
+                d.ok = readFile(_paths[i], d.content);
+                std::unique_lock<std::mutex> lock(mutex);
+                space.wait(lock, [&]()
+                { return done.size() < _inFlight; });
+                done.push_back(std::move(d));
+                ready.notify_one();
+            }
+        };
+        // the queue bounds the files held, the threads only need to keep the disk and the cores busy
+        size_t threads = std::min<size_t>({_inFlight, _paths.size(),
+                                           std::max(std::thread::hardware_concurrency(), 1u)});
+        std::vector<std::thread> readers;
+        for (size_t i = 0; i < threads; ++i)
+        {
+            readers.emplace_back(reader);
+        }
+        for (size_t handled = 0; handled < _paths.size(); ++handled)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&]()
+            { return !done.empty(); });
+            Done d = std::move(done.front());
+            done.pop_front();
+            space.notify_one();
+            lock.unlock();
+            handler(d.index, d.content, d.ok);
+        }
+        for (std::thread &t : readers)
+        {
+            t.join();
+        }
+    }
+
+    /**
+     *
+     * @param path
+     * @param content
+     * @return false if the file couldn't be read
+     */
+    static bool readFile(const std::string &path, std::string &content)
+    {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        file.seekg(0, std::ios::end);
+        std::streamoff size = file.tellg();
+        if (size < 0)
+        {
+            return false;
+        }
+        content.resize((size_t) size);
+        file.seekg(0, std::ios::beg);
+        file.read(&content[0], size);
+        content.resize((size_t) file.gcount());
+        return !file.bad();
+    }
+
+#ifdef BATCH_IO_URING
+
+    /**
+     * a minimal io_uring - the submission and completion rings mapped from the kernel
+     */
+    class Ring
+    {
+    public:
+        /**
+         *
+         * @param entries
+         */
+        explicit Ring(unsigned int entries)
+        {
+            io_uring_params params = {};
+            _fd = (int) syscall(__NR_io_uring_setup, entries, &params);
+            if (_fd < 0)
+            {
+                return;
+            }
+            _sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+            _cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            if (params.features & IORING_FEAT_SINGLE_MMAP)
+            {
+                _sqSize = _cqSize = std::max(_sqSize, _cqSize);
+            }
+            _sq = mmap(nullptr, _sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+            _cq = (params.features & IORING_FEAT_SINGLE_MMAP) ? _sq :
+                  mmap(nullptr, _cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+            _sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+            void *sqes = mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd,
+                              IORING_OFF_SQES);
+            _sqes = sqes == MAP_FAILED ? nullptr : (io_uring_sqe *) sqes;
+            if (_sq == MAP_FAILED || _cq == MAP_FAILED || _sqes == nullptr)
+            {
+                _release();
+                return;
+            }
+            auto *sq = (char *) _sq;
+            auto *cq = (char *) _cq;
+            _sqHead = (unsigned int *) (sq + params.sq_off.head);
+            _sqTail = (unsigned int *) (sq + params.sq_off.tail);
+            _sqMask = *(unsigned int *) (sq + params.sq_off.ring_mask);
+            _sqEntries = params.sq_entries;
+            _sqArray = (unsigned int *) (sq + params.sq_off.array);
+            _cqHead = (unsigned int *) (cq + params.cq_off.head);
+            _cqTail = (unsigned int *) (cq + params.cq_off.tail);
+            _cqMask = *(unsigned int *) (cq + params.cq_off.ring_mask);
+            _cqes = (io_uring_cqe *) (cq + params.cq_off.cqes);
+            _tail = *_sqTail;
+        }
+
+        Ring(const Ring &) = delete;
+
+        Ring &operator=(const Ring &) = delete;
+
+        /**
+         *
+         */
+        ~Ring()
+        {
+            _release();
+        }
+
+        /**
+         *
+         * @return true if the kernel gave us a ring
+         */
+        bool ok() const
+        {
+            return _fd >= 0;
+        }
+
+        /**
+         * asks the kernel which operations it knows - the ring itself came with 5.1, openat, read and close only with
+         * 5.6, and the probe with them
+         * @param opcodes
+         * @return true iff every opcode is supported
+         */
+        bool supports(std::initializer_list<unsigned char> opcodes) const
+        {
+            std::vector<char> buffer(sizeof(io_uring_probe) + IORING_PROBE_OPS * sizeof(io_uring_probe_op), 0);
+            auto *probe = (io_uring_probe *) buffer.data();
+            if (syscall(__NR_io_uring_register, _fd, IORING_REGISTER_PROBE, probe, IORING_PROBE_OPS) < 0)
+            {
+                return false;
+            }
+            for (unsigned char opcode : opcodes)
+            {
+                if (opcode > probe->last_op || !(probe->ops[opcode].flags & IO_URING_OP_SUPPORTED))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         *
+         * @return true once a submission failed, the ring can't be relied on anymore
+         */
+        bool broken() const
+        {
+            return _broken;
+        }
+
+        /**
+         * @return a cleared submission entry, submitting what is queued first if the ring is full - on a broken
+         * ring an entry that is never submitted
+         */
+        io_uring_sqe *next()
+        {
+            if (_tail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE) == _sqEntries && !enter(0))
+            {
+                _broken = true;
+            }
+            if (_broken || _tail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE) == _sqEntries)
+            {
+                _broken = true;
+                _scratch = io_uring_sqe();
+                return &_scratch;
+            }
+            unsigned int index = _tail & _sqMask;
+            _sqArray[index] = index;
+            ++_tail;
+            io_uring_sqe *sqe = &_sqes[index];
+            *sqe = io_uring_sqe();
+            return sqe;
+        }
+
+        /**
+         * submits every entry the kernel hasn't taken yet, including ones a failed call left behind
+         * @param wait the number of completions to wait for
+         * @return false on error, the ring is broken then
+         */
+        bool enter(unsigned int wait)
+        {
+            if (_broken)
+            {
+                return false;
+            }
+            __atomic_store_n(_sqTail, _tail, __ATOMIC_RELEASE);
+            while (true)
+            {
+                unsigned int queued = _tail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+                long res = syscall(__NR_io_uring_enter, _fd, queued, wait, wait ? IORING_ENTER_GETEVENTS : 0,
+                                   nullptr, 0);
+                if (res >= 0)
+                {
+                    return true;
+                }
+                if (errno != EINTR)
+                {
+                    _broken = true;
+                    return false;
+                }
+            }
+        }
+
+        /**
+         * @param cqe the next completion, if there is one
+         * @return false if no completion is waiting
+         */
+        bool pop(io_uring_cqe &cqe)
+        {
+            unsigned int head = *_cqHead;
+            if (head == __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE))
+            {
+                return false;
+            }
+            cqe = _cqes[head & _cqMask];
+            __atomic_store_n(_cqHead, head + 1, __ATOMIC_RELEASE);
+            return true;
+        }
+
+    private:
+        int _fd;
+        void *_sq = MAP_FAILED;
+        void *_cq = MAP_FAILED;
+        size_t _sqSize = 0;
+        size_t _cqSize = 0;
+        size_t _sqesSize = 0;
+        unsigned int *_sqHead = nullptr;
+        unsigned int *_sqTail = nullptr;
+        unsigned int *_sqArray = nullptr;
+        unsigned int _sqMask = 0;
+        unsigned int _sqEntries = 0;
+        unsigned int *_cqHead = nullptr;
+        unsigned int *_cqTail = nullptr;
+        unsigned int _cqMask = 0;
+        io_uring_cqe *_cqes = nullptr;
+        io_uring_sqe *_sqes = nullptr;
+        unsigned int _tail = 0;
+        bool _broken = false;
+        // handed out instead of a ring entry once the ring is broken
+        io_uring_sqe _scratch = io_uring_sqe();
+
+        /**
+         *
+         */
+        void _release()
+        {
+            if (_sqes != nullptr)
+            {
+                munmap(_sqes, _sqesSize);
+                _sqes = nullptr;
+            }
+            if (_cq != MAP_FAILED && _cq != _sq)
+            {
+                munmap(_cq, _cqSize);
+            }
+            if (_sq != MAP_FAILED)
+            {
+                munmap(_sq, _sqSize);
+            }
+            _sq = _cq = MAP_FAILED;
+            if (_fd >= 0)
+            {
+                close(_fd);
+                _fd = -1;
+            }
+        }
+    };
+
+    /**
+     * one file being read - opened, then read until a read returns nothing, then closed
+     */
+    struct Slot
+    {
+        size_t index;
+        int fd;
+        bool opening;
+        std::string content;
+        size_t length;
+    };
+
+    /**
+     * the io_uring path
+     * @tparam Handler
+     * @param handler
+     * @return false if io_uring isn't available, nothing was handled then
+     */
+    template<typename Handler>
+    bool _runRing(Handler &handler)
+    {
+        unsigned int entries = 1;
+        while (entries < 2 * _inFlight)
+        {
+            entries *= 2;
+        }
+        // the buffers outlive the ring, the kernel may still write to them until it is closed
+        std::vector<Slot> slots(std::min<size_t>(_inFlight, _paths.size()));
+        Ring ring(entries);
+        if (!ring.ok() || !ring.supports({IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE}))
+        {
+            return false;
+        }
+        _usedRing = true;
+        size_t next = 0;
+        size_t handled = 0;
+        for (size_t s = 0; s < slots.size(); ++s)
+        {
+            _open(ring, slots, s, next++);
+        }
+        std::vector<Slot> finished;
+        std::vector<bool> done(_paths.size(), false);
+        while (handled < _paths.size())
+        {
+            if (!ring.enter(1))
+            {
+                // the ring broke down, whatever wasn't handled yet is read the plain way
+                for (size_t i = 0; i < _paths.size(); ++i)
+                {
+                    if (!done[i])
+                    {
+                        std::string content;
+                        bool ok = readFile(_paths[i], content);
+                        handler(i, content, ok);
+                    }
+                }
+                break;
+            }
+            io_uring_cqe cqe;
+            while (ring.pop(cqe))
+            {
+                if (cqe.user_data == CLOSE_TAG)
+                {
+                    continue;
+                }
+                size_t s = (size_t) cqe.user_data;
+                Slot &slot = slots[s];
+                if (cqe.res < 0)
+                {
+                    if (!slot.opening)
+                    {
+                        _close(ring, slot.fd);
+                    }
+                    slot.length = std::string::npos;
+                }
+                else if (slot.opening)
+                {
+                    slot.opening = false;
+                    slot.fd = cqe.res;
+                    _read(ring, slots, s);
+                    continue;
+                }
+                else if (cqe.res > 0)
+                {
+                    // a read may return less than asked for before the end of the file, only 0 ends it
+                    slot.length += cqe.res;
+                    _read(ring, slots, s);
+                    continue;
+                }
+                else
+                {
+                    _close(ring, slot.fd);
+                }
+                finished.push_back(std::move(slot));
+                if (next < _paths.size())
+                {
+                    _open(ring, slots, s, next++);
+                }
+            }
+            // the next reads are already queued, they go to the kernel before the handler runs - if they can't,
+            // the enter(1) above finds the ring broken and the rest is read the plain way
+            ring.enter(0);
+            for (Slot &slot : finished)
+            {
+                bool ok = slot.length != std::string::npos;
+                slot.content.resize(ok ? slot.length : 0);
+                done[slot.index] = true;
+                handler(slot.index, slot.content, ok);
+                ++handled;
+            }
+            finished.clear();
+        }
+        return true;
+    }
+
+    /**
+     *
+     * @param ring
+     * @param slots
+     * @param s
+     * @param index
+     */
+    void _open(Ring &ring, std::vector<Slot> &slots, size_t s, size_t index)
+    {
+        slots[s] = Slot{index, -1, true, std::string(), 0};
+        io_uring_sqe *sqe = ring.next();
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (unsigned long long) _paths[index].c_str();
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        sqe->user_data = s;
+    }
+
+    /**
+     * reads the rest of the buffer - the first buffer holds the whole file and one more byte, so the read that
+     * finds the end has room, and a full buffer is doubled
+     * @param ring
+     * @param slots
+     * @param s
+     */
+    static void _read(Ring &ring, std::vector<Slot> &slots, size_t s)
+    {
+        Slot &slot = slots[s];
+        if (slot.content.empty())
+        {
+            struct stat status;
+            bool sized = fstat(slot.fd, &status) == 0 && status.st_size > 0;
+            slot.content.resize(sized ? (size_t) status.st_size + 1 : READ_CHUNK);
+        }
+        else if (slot.length == slot.content.size())
+        {
+            slot.content.resize(2 * slot.content.size());
+        }
+        io_uring_sqe *sqe = ring.next();
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = slot.fd;
+        sqe->addr = (unsigned long long) (slot.content.data() + slot.length);
+        sqe->len = (unsigned int) (slot.content.size() - slot.length);
+        sqe->off = slot.length;
+        sqe->user_data = s;
+    }
+
+    /**
+     *
+     * @param ring
+     * @param fd
+     */
+    static void _close(Ring &ring, int fd)
+    {
+        io_uring_sqe *sqe = ring.next();
+        sqe->opcode = IORING_OP_CLOSE;
+        sqe->fd = fd;
+        sqe->user_data = CLOSE_TAG;
+    }
+
+#endif
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include <cstdint>
+#include <vector>
+
+#ifndef BLOOMFILTER
+#define BLOOMFILTER
+
+#define BLOOM_BLOCK_BITS 512
+#define BLOOM_BITS_PER_KEY 10
+#define BLOOM_PROBES 7
+
+/**
+ * Blocked bloom filter - every key lives in one 64 byte block, so a query reads a single cache line.
+ * Keys are given as 64 bit hashes, the caller decides how to hash.
+ */
+class BloomFilter
+{
+public:
+    /**
+     * default ctor, an empty filter that rejects everything
+     */
+    BloomFilter() : _blocks(1)
+    {}
+
+    /**
+     *
+     * @param keys the number of keys that will be inserted
+     */
+    explicit BloomFilter(size_t keys) : _blocks(keys * BLOOM_BITS_PER_KEY / BLOOM_BLOCK_BITS + 1)
+    {}
+
+    /**
+     *
+     * @param hash
+     */
+    void insert(uint64_t hash)
+    {
+        Block &block = _blocks[_blockIndex(hash)];
+        uint32_t h1 = (uint32_t) hash;
+        uint32_t h2 = (uint32_t) (hash >> 32) | 1;
+        for (int i = 0; i < BLOOM_PROBES; ++i)
+        {
+            uint32_t bit = (h1 + i * h2) % BLOOM_BLOCK_BITS;
+            block.words[bit / 64] |= 1ULL << (bit % 64);
+        }
+    }
+
+    /**
+     *
+     * @param hash
+     * @return false if the key was surely never inserted
+     */
+    bool mayContain(uint64_t hash) const
+    {
+        const Block &block = _blocks[_blockIndex(hash)];
+        uint32_t h1 = (uint32_t) hash;
+        uint32_t h2 = (uint32_t) (hash >> 32) | 1;
+        for (int i = 0; i < BLOOM_PROBES; ++i)
+        {
+            uint32_t bit = (h1 + i * h2) % BLOOM_BLOCK_BITS;
+            if (!(block.words[bit / 64] & (1ULL << (bit % 64))))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     *
+     * @return the expected false positive rate, from how full each block is
+     */
+    double falsePositiveRate() const
+    {
+        double sum = 0;
+        for (const Block &block : _blocks)
+        {
+            int set = 0;
+            for (uint64_t word : block.words)
+            {
+                set += __builtin_popcountll(word);
+            }
+            double fill = (double) set / BLOOM_BLOCK_BITS;
+            double p = 1;
+            for (int i = 0; i < BLOOM_PROBES; ++i)
+            {
+                p *= fill;
+            }
+            sum += p;
+        }
+        return sum / _blocks.size();
+    }
+
+    /**
+     *
+     * @return the size of the filter in bytes
+     */
+    size_t bytes() const
+    {
+        return _blocks.size() * sizeof(Block);
+    }
+
+private:
+    /**
+     * one cache line of bits
+     */
+    struct alignas(64) Block
+    {
+        uint64_t words[BLOOM_BLOCK_BITS / 64] = {};
+    };
+
+    std::vector<Block> _blocks;
+
+    /**
+     *
+     * @param hash
+     * @return the block of the key - the high bits, the low bits choose the bits inside the block
+     */
+    size_t _blockIndex(uint64_t hash) const
+    {
+        return (size_t) (((hash >> 32) * _blocks.size()) >> 32);
+    }
+};
+
+#endif
@@ -0,0 +1,130 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "SpamDetector.hpp"
+#include "EmbeddedDictionary.hpp"
+
+#define INVALID "Invalid input"
+#define WRONG_NUMBER_OF_PARAMETERS "Usage: DictionaryGenerator <database path> <output header>"
+
+/**
+ * Reads the bad words CSV with SpamDetector's own loader and writes a header holding the phrases ready for the
+ * matchers (lower case, entries that only differ in case merged), so a SpamDetector built with
+ * USE_EMBEDDED_DICTIONARY doesn't read or parse anything at startup.
+ */
+class DictionaryGenerator
+{
+private:
+    std::vector<Phrase> _phrases;
+
+public:
+    /**
+     * reads the database - parsing, a repeated key and case merging all go as in SpamDetector::loadDataBase
+     * @param badWordsFile
+     */
+    void loadDataBase(std::ifstream &badWordsFile)
+    {
+        std::string msg;
+        SpamDetector detector(1, 0, msg);
+        detector.readDataBase(badWordsFile);
+        _phrases = detector.phrases();
+    }
+
+    /**
+     * writes the generated header
+     * @param out
+     * @param source the database path, for the header comment
+     */
+    void write(std::ostream &out, const std::string &source) const
+    {
+        out << "// Generated by DictionaryGenerator from " << source << " - do not edit.\n"
+            << "#include \"EmbeddedDictionary.hpp\"\n\n"
+            << "#ifndef EMBEDDEDBADWORDS\n#define EMBEDDEDBADWORDS\n\n"
+            << "#define EMBEDDED_PHRASE_COUNT " << _phrases.size() << "\n\n";
+        if (_phrases.empty())
+        {
+            out << "// an empty database still needs one element, it is never read\n";
+        }
+        out << "constexpr EmbeddedPhrase EMBEDDED_PHRASES[" << std::max<size_t>(_phrases.size(), 1) << "] = {\n";
+        for (const Phrase &p : _phrases)
+        {
+            out << "    {";
+            writeLiteral(out, p.text);
+            out << ", " << p.points << ", " << p.entries << "},\n";
+        }
+        if (_phrases.empty())
+        {
+            out << "    {{}, 0, 0},\n";
+        }
+        out << "};\n\n#endif\n";
+    }
+
+private:
+    /**
+     * writes s as a string_view literal, escaping everything that isn't plain printable ascii
+     * @param out
+     * @param s
+     */
+    static void writeLiteral(std::ostream &out, std::string_view s)
+    {
+        static const char digits[] = "01234567";
+        out << "std::string_view(\"";
+        for (char c : s)
+        {
+            auto u = (unsigned char) c;
+            if (u == '"' || u == '\\')
+            {
+                out << '\\' << c;
+            }
+            else if (u < 0x20 || u >= 0x7f || u == '?')
+            {
+                out << '\\' << digits[u >> 6] << digits[(u >> 3) & 7] << digits[u & 7];
+            }
+            else
+            {
+                out << c;
+            }
+        }
+        out << "\", " << s.size() << ")";
+    }
+};
+
+/**
+ *
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        std::cerr << WRONG_NUMBER_OF_PARAMETERS << std::endl;
+        return EXIT_FAILURE;
+    }
+    try
+    {
+        std::ifstream badWordsFile(argv[1], std::fstream::in);
+        if (!badWordsFile.is_open())
+        {
+            std::cerr << INVALID << std::endl;
+            return EXIT_FAILURE;
+        }
+        DictionaryGenerator generator;
+        generator.loadDataBase(badWordsFile);
+        std::ofstream out(argv[2], std::fstream::out | std::fstream::trunc);
+        if (!out.is_open())
+        {
+            std::cerr << INVALID << std::endl;
+            return EXIT_FAILURE;
+        }
+        generator.write(out, argv[1]);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << INVALID << std::endl;
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#ifndef DOUBLEARRAYTRIE
+#define DOUBLEARRAYTRIE
+
+#define TRIE_LABELS 257
+#define TRIE_END_LABEL 0
+#define TRIE_FREE (-1)
+#define TRIE_ROOT 0
+
+/**
+ * Double-array trie over byte strings - node s has a child by label l at t = base[s] + l iff check[t] == s. Labels
+ * are the byte + 1, label 0 leads from the node that ends a key to a leaf whose base holds -(value + 1).
+ * Shared prefixes are stored once and every node costs two int32s, so a large dictionary takes a fraction of
+ * the memory of a HashMap of strings.
+ */
+class DoubleArrayTrie
+{
+public:
+    /**
+     * builds the trie, the keys must be distinct
+     * @param keys
+     * @param values the value of every key, non negative
+     */
+    void build(const std::vector<std::string_view> &keys, const std::vector<int> &values)
+    {
+        std::vector<int> order(keys.size());
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = (int) i;
+        }
+        std::sort(order.begin(), order.end(), [&keys](int a, int b)
+        { return keys[a] < keys[b]; });
+
+        _base.assign(TRIE_LABELS + 1, 0);
+        _check.assign(TRIE_LABELS + 1, TRIE_FREE);
+        _nextFree.assign(TRIE_LABELS + 1, 0);
+        _prevFree.assign(TRIE_LABELS + 1, 0);
+        for (int p = 0; p <= TRIE_LABELS; ++p)
+        {
+            _nextFree[p] = p + 1;
+            _prevFree[p] = p - 1;
+        }
+        _firstFree = 0;
+        _lastFree = TRIE_LABELS;
+        _take(TRIE_ROOT, TRIE_ROOT);
+        _maxUsed = TRIE_ROOT;
+
+        // (node, first key, end key, depth) - the keys in [first, end) all go through node
+        struct Task
+        {
+            int node;
+            size_t begin;
+            size_t end;
+            size_t depth;
+        };
+        std::vector<Task> tasks;
+        if (!order.empty())
+        {
+            tasks.push_back({TRIE_ROOT, 0, order.size(), 0});
+        }
+        std::vector<int> labels;
+        std::vector<size_t> starts;
+        while (!tasks.empty())
+        {
+            Task task = tasks.back();
+            tasks.pop_back();
+            labels.clear();
+            starts.clear();
+            for (size_t k = task.begin; k < task.end; ++k)
+            {
+                std::string_view key = keys[order[k]];
+                int label = key.size() == task.depth ? TRIE_END_LABEL : (unsigned char) key[task.depth] + 1;
+                if (labels.empty() || labels.back() != label)
+                {
+                    labels.push_back(label);
+                    starts.push_back(k);
+                }
+            }
+            starts.push_back(task.end);
+            int base = _findBase(labels);
+            _base[task.node] = base;
+            for (size_t c = 0; c < labels.size(); ++c)
+            {
+                int child = base + labels[c];
+                _take(child, task.node);
+                if (labels[c] == TRIE_END_LABEL)
+                {
+                    _base[child] = -(values[order[starts[c]]] + 1);
+                }
+                else
+                {
+                    tasks.push_back({child, starts[c], starts[c + 1], task.depth + 1});
+                }
+            }
+        }
+        _base.resize(_maxUsed + 1);
+        _check.resize(_maxUsed + 1);
+        _base.shrink_to_fit();
+        _check.shrink_to_fit();
+        std::vector<int>().swap(_nextFree);
+        std::vector<int>().swap(_prevFree);
+    }
+
+    /**
+     * exact lookup
+     * @param key
+     * @param size
+     * @return the value of the key, or -1
+     */
+    int find(const char *key, size_t size) const
+    {
+        if (_base.empty())
+        {
+            return -1;
+        }
+        int node = TRIE_ROOT;
+        for (size_t i = 0; i < size; ++i)
+        {
+            node = child(node, (unsigned char) key[i]);
+            if (node < 0)
+            {
+                return -1;
+            }
+        }
+        return value(node);
+    }
+
+    /**
+     * walks the keys that are prefixes of text
+     * @tparam Visit callable as visit(int value, size_t length)
+     * @param text
+     * @param size
+     * @param visit called for every key that text starts with, shortest first
+     */
+    template<typename Visit>
+    void prefixes(const char *text, size_t size, Visit &visit) const
+    {
+        if (_base.empty())
+        {
+            return;
+        }
+        int node = TRIE_ROOT;
+        for (size_t i = 0; i < size; ++i)
+        {
+            node = child(node, (unsigned char) text[i]);
+            if (node < 0)
+            {
+                return;
+            }
+            int v = value(node);
+            if (v >= 0)
+            {
+                visit(v, i + 1);
+            }
+        }
+    }
+
+    /**
+     *
+     * @return the number of slots in the arrays
+     */
+    size_t slots() const
+    {
+        return _base.size();
+    }
+
+    /**
+     *
+     * @return the size of the arrays in bytes
+     */
+    size_t bytes() const
+    {
+        return _base.size() * sizeof(int) + _check.size() * sizeof(int);
+    }
+
+private:
+    std::vector<int> _base;
+    std::vector<int> _check;
+    // free slots as a doubly linked list, only while building
+    std::vector<int> _nextFree;
+    std::vector<int> _prevFree;
+    int _firstFree = 0;
+    int _lastFree = -1;
+    int _maxUsed = 0;
+
+    /**
+     *
+     * @param node
+     * @param c
+     * @return the child of node by byte c, or -1
+     */
+    int child(int node, unsigned char c) const
+    {
+        int base = _base[node];
+        if (base <= 0)
+        {
+            return -1;
+        }
+        size_t t = (size_t) base + c + 1;
+        return t < _check.size() && _check[t] == node ? (int) t : -1;
+    }
+
+    /**
+     *
+     * @param node
+     * @return the value of the key that ends at node, or -1
+     */
+    int value(int node) const
+    {
+        int base = _base[node];
+        if (base <= 0)
+        {
+            return -1;
+        }
+        size_t t = (size_t) base + TRIE_END_LABEL;
+        return t < _check.size() && _check[t] == node ? -_base[t] - 1 : -1;
+    }
+
+    /**
+     * grows the arrays so that slot p exists, the new slots are appended to the free list
+     * @param p
+     */
+    void _reserve(size_t p)
+    {
+        size_t old = _check.size();
+        if (p < old)
+        {
+            return;
+        }
+        size_t size = std::max(p + 1, 2 * old);
+        _base.resize(size, 0);
+        _check.resize(size, TRIE_FREE);
+        _nextFree.resize(size);
+        _prevFree.resize(size);
+        for (size_t q = old; q < size; ++q)
+        {
+            _nextFree[q] = (int) q + 1;
+            _prevFree[q] = (int) q - 1;
+        }
+        // the last free slot (or _firstFree, if none was left) already points at old, one past the end
+        _prevFree[old] = _lastFree;
+        _lastFree = (int) size - 1;
+    }
+
+    /**
+     * marks a free slot as used by a child of parent
+     * @param p
+     * @param parent
+     */
+    void _take(int p, int parent)
+    {
+        _reserve(p);
+        _check[p] = parent == p ? -2 : parent;
+        int prev = _prevFree[p];
+        int next = _nextFree[p];
+        if (prev >= 0)
+        {
+            _nextFree[prev] = next;
+        }
+        else
+        {
+            _firstFree = next;
+        }
+        if (next < (int) _check.size())
+        {
+            _prevFree[next] = prev;
+        }
+        else
+        {
+            _lastFree = prev;
+        }
+        _maxUsed = std::max(_maxUsed, p);
+    }
+
+    /**
+     * @param labels sorted labels
+     * @return a base where every label lands on a free slot
+     */
+    int _findBase(const std::vector<int> &labels)
+    {
+        for (int p = _firstFree;; p = _nextFree[p])
+        {
+            _reserve((size_t) p + TRIE_LABELS);
+            int base = p - labels[0];
+            if (base < 1)
+            {
+                continue;
+            }
+            bool fits = true;
+            for (size_t c = 1; c < labels.size() && fits; ++c)
+            {
+                fits = _check[base + labels[c]] == TRIE_FREE;
+            }
+            if (fits)
+            {
+                return base;
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,17 @@
+#include <string_view>
+
+#ifndef EMBEDDEDDICTIONARY
+#define EMBEDDEDDICTIONARY
+
+/**
+ * one phrase of a generated bad words table - lower case, with the points of all the database entries that lower
+ * case to it, the way SpamDetector::compile merges them
+ */
+struct EmbeddedPhrase
+{
+    std::string_view phrase;
+    int points;
+    int entries;
+};
+
+#endif
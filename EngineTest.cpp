@@ -0,0 +1,130 @@
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "MatcherFactory.hpp"
+#include "TestData.hpp"
+
+/**
+ * what a scan is expected to count
+ */
+struct Expected
+{
+    double points;
+    int matches;
+};
+
+/**
+ * the original counting rule, position by position - the model every engine is checked against
+ * @param phrases
+ * @param text
+ * @return
+ */
+Expected count(const std::vector<Phrase> &phrases, const std::string &text)
+{
+    Expected expected{0, 0};
+    for (const Phrase &phrase : phrases)
+    {
+        size_t position = 0;
+        while (position + phrase.text.size() <= text.size())
+        {
+            if (text.compare(position, phrase.text.size(), phrase.text) == 0)
+            {
+                expected.points += phrase.points;
+                expected.matches += phrase.entries;
+                position += phrase.text.size();
+            }
+            else
+            {
+                ++position;
+            }
+        }
+    }
+    return expected;
+}
+
+/**
+ * scans the text with one engine, whole and in pieces, and compares both with the model
+ * @param engine
+ * @param phrases
+ * @param text
+ * @param random picks the pieces
+ * @return true iff the engine counted what the model did
+ */
+bool check(const std::string &engine, const std::vector<Phrase> &phrases, const std::string &text,
+           std::mt19937 &random)
+{
+    std::unique_ptr<Matcher> matcher = MatcherFactory::make(engine);
+    matcher->build(phrases);
+    std::vector<PhraseWeight> weights = PhraseWeight::of(phrases);
+    Expected expected = count(phrases, text);
+
+    MatchCounter whole(weights);
+    matcher->scan(text.data(), text.size(), 0, text.size(), whole);
+    // consecutive ranges of one text, the way a large message is scanned
+    MatchCounter pieces(weights);
+    for (size_t begin = 0; begin < text.size();)
+    {
+        size_t end = std::min(text.size(), begin + 1 + random() % 200);
+        matcher->scan(text.data(), text.size(), begin, end, pieces);
+        begin = end;
+    }
+    bool ok = true;
+    for (const MatchCounter *counter : {&whole, &pieces})
+    {
+        if (counter->points() != expected.points || counter->matches() != expected.matches)
+        {
+            std::cerr << engine << ": " << phrases.size() << " phrases, " << text.size() << " chars, "
+                      << (counter == &whole ? "whole" : "in pieces") << " counted " << counter->points() << " / "
+                      << counter->matches() << " instead of " << expected.points << " / " << expected.matches
+                      << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+/**
+ *
+ * @return
+ */
+int main()
+{
+    std::mt19937 random(32);
+    bool ok = true;
+    int cases = 0;
+    // small alphabets make phrases overlap themselves and each other, sizes cross the dense counter limit
+    const std::vector<std::string> alphabets = {"a", "ab", "abc ", "abcdefghijklmnopqrstuvwxyz ,.!"};
+    const std::vector<size_t> counts = {1, 2, 7, 40, 300, 600, 5000};
+    for (const std::string &alphabet : alphabets)
+    {
+        for (size_t count : counts)
+        {
+            for (size_t maxLength : {1, 3, 8, 20})
+            {
+                std::vector<Phrase> phrases = TestData::dictionary(random, alphabet, count, maxLength);
+                for (size_t size : {0, 1, 31, 33, 100, 3000})
+                {
+                    std::string message = TestData::text(random, alphabet, size);
+                    for (const std::string &engine : MatcherFactory::engines())
+                    {
+                        ok &= check(engine, phrases, message, random);
+                        ++cases;
+                    }
+                }
+            }
+        }
+    }
+    // phrases that are prefixes and suffixes of each other, inside real words
+    std::vector<Phrase> nested = {{"free", 3, 1}, {"freemoney", 5, 2}, {"money", 2, 1}, {"e", 1, 1},
+                                  {"ee", 1, 1}, {"eee", 1, 1}, {"win big", 4, 1}, {"big", 1, 1}};
+    std::string message = " free freemoney win big money eeeeeee freefree winbig win big\n";
+    for (const std::string &engine : MatcherFactory::engines())
+    {
+        ok &= check(engine, nested, message, random);
+        ++cases;
+    }
+    std::cout << cases << " cases " << (ok ? "passed" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,63 @@
+#include <string_view>
+#include "Matcher.hpp"
+
+#ifndef FINDMATCHER
+#define FINDMATCHER
+
+/**
+ * The original search - one find loop over the text per phrase. Nothing to build, and the best choice for a
+ * handful of phrases.
+ */
+class FindMatcher : public Matcher
+{
+public:
+    /**
+     *
+     * @return
+     */
+    const char *name() const override
+    {
+        return "find";
+    }
+
+    /**
+     *
+     * @param phrases
+     */
+    void build(const std::vector<Phrase> &phrases) override
+    {
+        _phrases.clear();
+        for (const Phrase &phrase : phrases)
+        {
+            _phrases.push_back(phrase.text);
+        }
+    }
+
+    /**
+     *
+     * @param text
+     * @param size
+     * @param begin
+     * @param end
+     * @param counter
+     */
+    void scan(const char *text, size_t size, size_t begin, size_t end, MatchCounter &counter) const override
+    {
+        for (size_t id = 0; id < _phrases.size(); ++id)
+        {
+            // an occurrence that starts before end ends at most length - 1 chars after it, the rest isn't searched
+            std::string_view view(text, std::min(size, end + std::max<size_t>(_phrases[id].size(), 1) - 1));
+            size_t index = view.find(_phrases[id], begin);
+            while (index != std::string_view::npos && index < end)
+            {
+                counter.report((int) id, index);
+                index = view.find(_phrases[id], std::max(index + 1, counter.next((int) id)));
+            }
+        }
+    }
+
+private:
+    std::vector<std::string> _phrases;
+};
+
+#endif
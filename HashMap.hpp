@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cstddef>
 #include <vector>
 
 #ifndef HASHMAP
@@ -6,6 +8,14 @@
 #define START_CAPACITY 16
 #define HIGHER_BOUND_FACTOR 0.75
 #define LOWER_BOUND_FACTOR 0.25
+#define HASHMAP_BATCH 16
+#define HASHMAP_CHUNK 256
+
+#if defined(__GNUC__) || defined(__clang__)
+#define HASHMAP_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define HASHMAP_PREFETCH(address)
+#endif
 
 /**
  * an Exception class, derieves from std::exception
@@ -207,6 +217,78 @@ public:
         throw hashExceptions("in method at(): key not found");
     }
 
+    /**
+     * looks up many keys at once - the bucket of a key is prefetched HASHMAP_BATCH keys before it is searched, and
+     * its pairs half as many keys before, so the cache misses of the keys overlap instead of coming one by one
+     * @param keys
+     * @param count
+     * @param values values[i] is set to the value of keys[i], or nullptr if it isn't in the table
+     * @return the number of keys found
+     */
+    size_t findMany(const KeyT *keys, size_t count, const ValueT **values) const
+    {
+        // key i + 2 * distance gets its bucket prefetched, key i + distance the pairs of its bucket
+        const size_t distance = HASHMAP_BATCH / 2;
+        int indices[HASHMAP_BATCH];
+        for (size_t i = 0; i < std::min(count, (size_t) HASHMAP_BATCH); ++i)
+        {
+            indices[i] = _hash(keys[i]);
+            HASHMAP_PREFETCH(&_table[indices[i]]);
+        }
+        for (size_t i = 0; i < std::min(count, distance); ++i)
+        {
+            HASHMAP_PREFETCH(_table[indices[i]].data());
+        }
+        size_t found = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            int index = indices[i % HASHMAP_BATCH];
+            if (i + HASHMAP_BATCH < count)
+            {
+                indices[i % HASHMAP_BATCH] = _hash(keys[i + HASHMAP_BATCH]);
+                HASHMAP_PREFETCH(&_table[indices[i % HASHMAP_BATCH]]);
+            }
+            if (i + distance < count)
+            {
+                HASHMAP_PREFETCH(_table[indices[(i + distance) % HASHMAP_BATCH]].data());
+            }
+            values[i] = nullptr;
+            for (const std::pair<KeyT, ValueT> &pair : _table[index])
+            {
+                if (pair.first == keys[i])
+                {
+                    values[i] = &pair.second;
+                    ++found;
+                    break;
+                }
+            }
+        }
+        return found;
+    }
+
+    /**
+     * containsKey for many keys, HASHMAP_CHUNK keys at a time through findMany
+     * @param keys
+     * @param count
+     * @param contained contained[i] is set to true iff keys[i] is in the table
+     * @return the number of keys found
+     */
+    size_t containsMany(const KeyT *keys, size_t count, bool *contained) const
+    {
+        size_t found = 0;
+        const ValueT *values[HASHMAP_CHUNK];
+        for (size_t first = 0; first < count; first += HASHMAP_CHUNK)
+        {
+            size_t batch = std::min(count - first, (size_t) HASHMAP_CHUNK);
+            found += findMany(keys + first, batch, values);
+            for (size_t i = 0; i < batch; ++i)
+            {
+                contained[first + i] = values[i] != nullptr;
+            }
+        }
+        return found;
+    }
+
     /**
      *
      * @return true if erasing the key succeeded
@@ -305,7 +387,8 @@ public:
          */
         const_iterator(const HashMap<KeyT, ValueT> *hashMap) : _hashMap(hashMap), _bucket_index(0), _index_in_bucket(0)
         {
-            while (_hashMap->_table[_bucket_index].empty())
+            // an empty table has no bucket to stop at, the iterator is then at end()
+            while (_bucket_index < _hashMap->capacity() && _hashMap->_table[_bucket_index].empty())
             {
                 ++_bucket_index;
             }
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "HashMap.hpp"
+
+#define USAGE "Usage: HashMapBenchmark <keys> [rounds]"
+#define DEFAULT_ROUNDS 5
+
+/**
+ * the time per key of every way to look the queries up, in nanoseconds
+ */
+struct Timing
+{
+    double findSingle;
+    double findMany;
+    double containsSingle;
+    double containsMany;
+};
+
+/**
+ *
+ * @param start
+ * @param end
+ * @param keys
+ * @return nanoseconds per key
+ */
+double perKey(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end, size_t keys)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count() / keys;
+}
+
+/**
+ * looks every query up one at a time and in batches
+ * @tparam KeyT
+ * @param map
+ * @param queries
+ * @param timing
+ * @return false if the batched lookups found something else than the single ones
+ */
+template<typename KeyT>
+bool measure(const HashMap<KeyT, int> &map, const std::vector<KeyT> &queries, Timing &timing)
+{
+    std::vector<const int *> values(queries.size(), nullptr);
+    std::unique_ptr<bool[]> found(new bool[queries.size()]());
+
+    auto start = std::chrono::steady_clock::now();
+    size_t singleSum = 0;
+    for (const KeyT &key : queries)
+    {
+        if (map.containsKey(key))
+        {
+            singleSum += map.at(key);
+        }
+    }
+    auto singleEnd = std::chrono::steady_clock::now();
+    size_t manySum = 0;
+    map.findMany(queries.data(), queries.size(), values.data());
+    for (const int *value : values)
+    {
+        manySum += value == nullptr ? 0 : *value;
+    }
+    auto manyEnd = std::chrono::steady_clock::now();
+    size_t singleHits = 0;
+    for (const KeyT &key : queries)
+    {
+        singleHits += map.containsKey(key);
+    }
+    auto containsEnd = std::chrono::steady_clock::now();
+    size_t manyHits = map.containsMany(queries.data(), queries.size(), found.get());
+    auto end = std::chrono::steady_clock::now();
+
+    timing.findSingle = perKey(start, singleEnd, queries.size());
+    timing.findMany = perKey(singleEnd, manyEnd, queries.size());
+    timing.containsSingle = perKey(manyEnd, containsEnd, queries.size());
+    timing.containsMany = perKey(containsEnd, end, queries.size());
+    return singleSum == manySum && singleHits == manyHits;
+}
+
+/**
+ * measures a map several times and writes the median of every timing
+ * @tparam KeyT
+ * @param name
+ * @param map
+ * @param queries
+ * @param rounds
+ * @return false if a batched lookup was wrong
+ */
+template<typename KeyT>
+bool report(const std::string &name, const HashMap<KeyT, int> &map, const std::vector<KeyT> &queries, int rounds)
+{
+    std::vector<Timing> timings(rounds);
+    bool ok = true;
+    for (Timing &timing : timings)
+    {
+        ok &= measure(map, queries, timing);
+    }
+    auto median = [&timings](double Timing::*field)
+    {
+        std::vector<double> values;
+        for (const Timing &timing : timings)
+        {
+            values.push_back(timing.*field);
+        }
+        std::sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    };
+    std::cout << name << ", " << map.size() << " keys (ns per key): containsKey+at " << median(&Timing::findSingle)
+              << ", findMany " << median(&Timing::findMany) << ", containsKey " << median(&Timing::containsSingle)
+              << ", containsMany " << median(&Timing::containsMany) << (ok ? "" : " - MISMATCH") << std::endl;
+    return ok;
+}
+
+/**
+ * times single and batched lookups on a table of uint64 keys and one of string keys (half as many), with half of
+ * the queries hits, in random order
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << USAGE << std::endl;
+        return EXIT_FAILURE;
+    }
+    size_t keys = 0;
+    int rounds = DEFAULT_ROUNDS;
+    try
+    {
+        keys = std::stoul(argv[1]);
+        rounds = argc == 3 ? std::stoi(argv[2]) : DEFAULT_ROUNDS;
+    }
+    catch (const std::logic_error &)
+    {
+        keys = 0;
+    }
+    if (keys == 0 || rounds <= 0)
+    {
+        std::cerr << USAGE << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::mt19937_64 random(37);
+    bool ok = true;
+    {
+        HashMap<uint64_t, int> map;
+        std::vector<uint64_t> queries;
+        for (size_t i = 0; i < keys; ++i)
+        {
+            uint64_t key = random();
+            map.insert(key, (int) i);
+            queries.push_back(i % 2 == 0 ? key : random());
+        }
+        std::shuffle(queries.begin(), queries.end(), random);
+        ok &= report("uint64", map, queries, rounds);
+    }
+    {
+        HashMap<std::string, int> map;
+        std::vector<std::string> queries;
+        for (size_t i = 0; i < keys / 2; ++i)
+        {
+            std::string key = "phrase number " + std::to_string(random());
+            map.insert(key, (int) i);
+            queries.push_back(i % 2 == 0 ? key : "phrase number " + std::to_string(random()));
+        }
+        std::shuffle(queries.begin(), queries.end(), random);
+        ok &= report("std::string", map, queries, rounds);
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,183 @@
+#include <atomic>
+#include <cstdint>
+#include "Matcher.hpp"
+#include "HashMap.hpp"
+#include "BloomFilter.hpp"
+
+#ifndef LOOKUPMATCHER
+#define LOOKUPMATCHER
+
+#define WINDOW_HASH_START 0xcbf29ce484222325ULL
+#define WINDOW_HASH_PRIME 0x100000001b3ULL
+#define LOOKUP_BATCH 64
+
+/**
+ * Looks up every window of the text whose length is a phrase length. The window hash is extended one char at a
+ * time from each start position, and a blocked bloom filter rejects almost every window before the HashMap is
+ * touched. The windows that pass the filter are looked up LOOKUP_BATCH at a time with HashMap::findMany, so with
+ * a large dictionary their cache misses overlap. Cost depends on the phrase lengths, not on the number of phrases.
+ */
+class LookupMatcher : public Matcher
+{
+public:
+    /**
+     *
+     * @return
+     */
+    const char *name() const override
+    {
+        return "lookup";
+    }
+
+    /**
+     *
+     * @param phrases
+     */
+    void build(const std::vector<Phrase> &phrases) override
+    {
+        _phraseIds.clear();
+        _isPhraseLength.assign(1, false);
+        _filter = BloomFilter(phrases.size());
+        for (size_t id = 0; id < phrases.size(); ++id)
+        {
+            const std::string &text = phrases[id].text;
+            _phraseIds.insert(text, (int) id);
+            if (_isPhraseLength.size() <= text.size())
+            {
+                _isPhraseLength.resize(text.size() + 1, false);
+            }
+            _isPhraseLength[text.size()] = true;
+            uint64_t h = WINDOW_HASH_START;
+            for (char c : text)
+            {
+                h = windowHash(h, c);
+            }
+            _filter.insert(mix(h));
+        }
+    }
+
+    /**
+     *
+     * @param text
+     * @param size
+     * @param begin
+     * @param end
+     * @param counter
+     */
+    void scan(const char *text, size_t size, size_t begin, size_t end, MatchCounter &counter) const override
+    {
+        unsigned long queries = 0;
+        unsigned long members = 0;
+        unsigned long falsePositives = 0;
+        size_t maxLength = _isPhraseLength.size() - 1;
+        // the windows that passed the filter, in the order they are reported
+        std::string windows[LOOKUP_BATCH];
+        size_t starts[LOOKUP_BATCH];
+        const int *ids[LOOKUP_BATCH];
+        size_t pending = 0;
+        auto lookUp = [&]()
+        {
+            _phraseIds.findMany(windows, pending, ids);
+            for (size_t k = 0; k < pending; ++k)
+            {
+                if (ids[k] == nullptr)
+                {
+                    ++falsePositives;
+                    continue;
+                }
+                ++members;
+                counter.report(*ids[k], starts[k]);
+            }
+            pending = 0;
+        };
+        for (size_t i = begin; i < end; ++i)
+        {
+            uint64_t h = WINDOW_HASH_START;
+            size_t limit = std::min(maxLength, size - i);
+            for (size_t length = 1; length <= limit; ++length)
+            {
+                h = windowHash(h, text[i + length - 1]);
+                if (!_isPhraseLength[length])
+                {
+                    continue;
+                }
+                ++queries;
+                if (!_filter.mayContain(mix(h)))
+                {
+                    continue;
+                }
+                windows[pending].assign(text + i, length);
+                starts[pending++] = i;
+                if (pending == LOOKUP_BATCH)
+                {
+                    lookUp();
+                }
+            }
+        }
+        lookUp();
+        _queries += queries;
+        _members += members;
+        _falsePositives += falsePositives;
+    }
+
+    /**
+     *
+     * @param out
+     */
+    void printStats(std::ostream &out) const override
+    {
+        unsigned long negatives = _queries - _members;
+        out << "filter bytes: " << _filter.bytes() << std::endl;
+        out << "filter expected false positive rate: " << _filter.falsePositiveRate() << std::endl;
+        out << "filter queries: " << _queries << ", rejected: " << negatives - _falsePositives
+            << ", false positives: " << _falsePositives << std::endl;
+        out << "filter observed false positive rate: "
+            << (negatives == 0 ? 0 : (double) _falsePositives / negatives) << std::endl;
+    }
+
+    /**
+     *
+     */
+    void resetStats() override
+    {
+        _queries = 0;
+        _members = 0;
+        _falsePositives = 0;
+    }
+
+private:
+    HashMap<std::string, int> _phraseIds;
+    std::vector<bool> _isPhraseLength;
+    BloomFilter _filter;
+    mutable std::atomic<unsigned long> _queries{0};
+    mutable std::atomic<unsigned long> _members{0};
+    mutable std::atomic<unsigned long> _falsePositives{0};
+
+    /**
+     * FNV-1a step, so the hash of a window is extended by one char at a time
+     * @param h
+     * @param c
+     * @return
+     */
+    static uint64_t windowHash(uint64_t h, char c)
+    {
+        return (h ^ (unsigned char) c) * WINDOW_HASH_PRIME;
+    }
+
+    /**
+     * spreads the window hash over all 64 bits for the filter
+     * @param h
+     * @return
+     */
+    static uint64_t mix(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+};
+
+#endif
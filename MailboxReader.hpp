@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <istream>
+#include <string>
+
+#ifndef MAILBOXREADER
+#define MAILBOXREADER
+
+#define MBOX_CHUNK (1 << 20)
+#define MBOX_SEPARATOR "\nFrom "
+#define MBOX_SEPARATOR_SIZE 6
+
+/**
+ * Splits an mbox stream into its messages while reading it - a message starts at a line beginning with "From "
+ * and ends right before the next one. Only the message being split is held in memory.
+ */
+class MailboxReader
+{
+public:
+    /**
+     *
+     * @param in the mbox stream
+     */
+    explicit MailboxReader(std::istream &in) : _in(in)
+    {}
+
+    /**
+     * reads the next message, without its "From " line
+     * @param message
+     * @param offset the offset of the message's "From " line in the stream
+     * @return false when there are no more messages
+     */
+    bool next(std::string &message, unsigned long long &offset)
+    {
+        if (_start >= MBOX_CHUNK)
+        {
+            _compact();
+        }
+        while (_buffer.size() - _start < MBOX_SEPARATOR_SIZE && _fill())
+        {}
+        if (_start == _buffer.size())
+        {
+            return false;
+        }
+        offset = _base + _start;
+        // only the start of the stream can lack a "From " line, then that text is a message of its own
+        size_t bodyStart = _start;
+        if (_buffer.compare(_start, MBOX_SEPARATOR_SIZE - 1, MBOX_SEPARATOR + 1) == 0)
+        {
+            size_t lineEnd = _buffer.find('\n', _start);
+            while (lineEnd == std::string::npos && _fill())
+            {
+                lineEnd = _buffer.find('\n', _start);
+            }
+            bodyStart = lineEnd == std::string::npos ? _buffer.size() : lineEnd;
+        }
+        // searching from the newline of the "From " line itself finds an empty message
+        size_t from = bodyStart;
+        size_t separator = _buffer.find(MBOX_SEPARATOR, from);
+        while (separator == std::string::npos)
+        {
+            from = std::max(from, _buffer.size() - std::min(_buffer.size(), (size_t) MBOX_SEPARATOR_SIZE));
+            if (!_fill())
+            {
+                break;
+            }
+            separator = _buffer.find(MBOX_SEPARATOR, from);
+        }
+        size_t end = separator == std::string::npos ? _buffer.size() : separator + 1;
+        if (bodyStart < end && bodyStart != _start)
+        {
+            ++bodyStart;
+        }
+        message.assign(_buffer, bodyStart, end - std::min(end, bodyStart));
+        _start = end;
+        return true;
+    }
+
+private:
+    std::istream &_in;
+    std::string _buffer;
+    size_t _start = 0;
+    unsigned long long _base = 0;
+
+    /**
+     * appends the next chunk of the stream to the buffer
+     * @return false at the end of the stream
+     */
+    bool _fill()
+    {
+        size_t size = _buffer.size();
+        _buffer.resize(size + MBOX_CHUNK);
+        _in.read(&_buffer[size], MBOX_CHUNK);
+        _buffer.resize(size + (size_t) _in.gcount());
+        return _in.gcount() > 0;
+    }
+
+    /**
+     * drops the messages that were already returned
+     */
+    void _compact()
+    {
+        _buffer.erase(0, _start);
+        _base += _start;
+        _start = 0;
+    }
+};
+
+#endif
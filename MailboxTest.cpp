@@ -0,0 +1,167 @@
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "MailboxReader.hpp"
+
+/**
+ * one message as the mbox format defines it
+ */
+struct Message
+{
+    std::string body;
+    unsigned long long offset;
+
+    bool operator==(const Message &other) const
+    {
+        return body == other.body && offset == other.offset;
+    }
+};
+
+/**
+ * splits a whole mbox line by line - the model MailboxReader is checked against
+ * @param mbox
+ * @return the messages, a message starts at a line beginning with "From " and holds the lines up to the next one
+ */
+std::vector<Message> split(const std::string &mbox)
+{
+    std::vector<Message> messages;
+    size_t position = 0;
+    while (position < mbox.size())
+    {
+        size_t lineEnd = mbox.find('\n', position);
+        lineEnd = lineEnd == std::string::npos ? mbox.size() : lineEnd + 1;
+        if (mbox.compare(position, 5, "From ") == 0)
+        {
+            messages.push_back(Message{std::string(), position});
+        }
+        else
+        {
+            if (messages.empty())
+            {
+                messages.push_back(Message{std::string(), 0});
+            }
+            messages.back().body.append(mbox, position, lineEnd - position);
+        }
+        position = lineEnd;
+    }
+    return messages;
+}
+
+/**
+ *
+ * @param mbox
+ * @return the messages MailboxReader reads from mbox
+ */
+std::vector<Message> read(const std::string &mbox)
+{
+    std::istringstream in(mbox);
+    MailboxReader reader(in);
+    std::vector<Message> messages;
+    Message message;
+    while (reader.next(message.body, message.offset))
+    {
+        messages.push_back(message);
+    }
+    return messages;
+}
+
+/**
+ * compares the reader with the model on one mbox
+ * @param name
+ * @param mbox
+ * @return true iff they agree
+ */
+bool check(const std::string &name, const std::string &mbox)
+{
+    std::vector<Message> expected = split(mbox);
+    std::vector<Message> found = read(mbox);
+    if (found == expected)
+    {
+        return true;
+    }
+    std::cerr << name << ": expected " << expected.size() << " messages, read " << found.size() << std::endl;
+    for (size_t i = 0; i < std::min(found.size(), expected.size()); ++i)
+    {
+        if (!(found[i] == expected[i]))
+        {
+            std::cerr << "  first difference at message " << i << ", offset " << expected[i].offset << " / "
+                      << found[i].offset << ", " << expected[i].body.size() << " / " << found[i].body.size()
+                      << " bytes" << std::endl;
+            break;
+        }
+    }
+    return false;
+}
+
+/**
+ * a message body of size bytes, full of newlines and "From" pieces - most are no separators, the ones that happen
+ * to start a line with "From " are
+ * @param random
+ * @param size
+ * @return
+ */
+std::string body(std::mt19937 &random, size_t size)
+{
+    static const std::string pieces[] = {"hello ", "From", " From ", "\n", ">From x\n", "from y\n", "\nFrom", "x"};
+    std::string text;
+    while (text.size() < size)
+    {
+        text += pieces[random() % (sizeof(pieces) / sizeof(pieces[0]))];
+    }
+    text.resize(size);
+    return text;
+}
+
+/**
+ *
+ * @return
+ */
+int main()
+{
+    bool ok = true;
+    ok &= check("empty mbox", "");
+    ok &= check("no From line", "just some text\nwithout a separator\n");
+    ok &= check("no trailing newline", "From a\nfirst\nFrom b\nsecond");
+    ok &= check("text before the first From line", "leading text\nFrom a\nbody\n");
+    ok &= check("From mid-line", "From a\nthis line says From here\nand From \nFrom b\nlast\n");
+    ok &= check("From without a space", "From a\nFromage\nFrom\nFrom b\n");
+    ok &= check("empty messages", "From a\nFrom b\n\nFrom c");
+    ok &= check("only a From line", "From a");
+    ok &= check("From line ends the mbox", "From a\nbody\nFrom b\n");
+    ok &= check("newlines only", "\n\n\n");
+
+    // a separator at and around every position of the first chunk border
+    for (int shift = -8; shift <= 8; ++shift)
+    {
+        std::string mbox = "From a\n";
+        mbox += std::string(MBOX_CHUNK + shift - mbox.size(), 'x');
+        mbox += "\nFrom b\nsecond message\n";
+        ok &= check("separator at chunk border " + std::to_string(shift), mbox);
+    }
+    // a From line longer than a chunk, and a message longer than two chunks
+    ok &= check("long From line", "From " + std::string(MBOX_CHUNK + 3, 'a') + "\nbody\nFrom b\n");
+    ok &= check("long message", "From a\n" + std::string(2 * MBOX_CHUNK + 5, 'b') + "\nFrom b\nend");
+
+    // many messages across several chunks, so the buffer is compacted on the way
+    std::mt19937 random(29);
+    for (int round = 0; round < 20; ++round)
+    {
+        std::string mbox = round % 2 == 0 ? "" : body(random, random() % 100);
+        while (mbox.size() < 3 * MBOX_CHUNK)
+        {
+            if (!mbox.empty() && mbox.back() != '\n')
+            {
+                mbox += '\n';
+            }
+            mbox += "From sender " + std::to_string(random()) + "\n";
+            mbox += body(random, random() % (round < 10 ? 4096 : MBOX_CHUNK / 2));
+        }
+        ok &= check("random mbox " + std::to_string(round), mbox);
+    }
+
+    std::cout << (ok ? "passed" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
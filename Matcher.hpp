@@ -0,0 +1,369 @@
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "HashMap.hpp"
+
+#ifndef MATCHER
+#define MATCHER
+
+#define DENSE_COUNTER_MAX 4096
+
+/**
+ * a bad phrase as the matchers see it - lower case, with the points of all the database entries that lower case
+ * to it (entries that only differ in case count the same occurrences)
+ */
+struct Phrase
+{
+    std::string text;
+    int points;
+    int entries;
+};
+
+/**
+ * what counting needs to know about a phrase, without the phrase itself
+ */
+struct PhraseWeight
+{
+    size_t length;
+    int points;
+    int entries;
+
+    /**
+     *
+     * @param phrases
+     * @return the weights of the phrases, by the same ids
+     */
+    static std::vector<PhraseWeight> of(const std::vector<Phrase> &phrases)
+    {
+        std::vector<PhraseWeight> weights;
+        weights.reserve(phrases.size());
+        for (const Phrase &phrase : phrases)
+        {
+            weights.push_back(PhraseWeight{phrase.text.size(), phrase.points, phrase.entries});
+        }
+        return weights;
+    }
+};
+
+/**
+ * Counts the occurrences a matcher reports, with the rule of the original find loop - an occurrence of a phrase is
+ * counted only if it starts after the end of the previous counted occurrence of the same phrase.
+ * Large dictionaries keep the positions only of the phrases that matched, so a counter stays cheap to create.
+ * A segment counter counts a segment of a text as if nothing was counted before it, and remembers where each
+ * phrase was first counted, so the segment can be scanned before the segments ahead of it are counted - add() then
+ * fixes up only the phrases whose first occurrence overlaps one counted ahead of the segment. A text that is
+ * scanned one window at a time sets the offset of every window, so the matchers see positions in the window and
+ * the counter positions in the text.
+ */
+class MatchCounter
+{
+public:
+    /**
+     *
+     * @param weights
+     * @param segment true to remember the first counted occurrence of every phrase, for add()
+     */
+    explicit MatchCounter(const std::vector<PhraseWeight> &weights, bool segment = false) :
+            _weights(weights), _dense(weights.size() <= DENSE_COUNTER_MAX), _segment(segment)
+    {
+        if (_dense)
+        {
+            _next.assign(weights.size(), 0);
+        }
+    }
+
+    /**
+     *
+     * @param id
+     * @param position
+     */
+    void report(int id, size_t position)
+    {
+        if (position < next(id))
+        {
+            return;
+        }
+        position += _offset;
+        const PhraseWeight &weight = _weights[id];
+        if (_segment && _stored(id) == 0)
+        {
+            _touched.emplace_back(id, position);
+        }
+        _store(id, position + weight.length);
+        _points += weight.points;
+        _matches += weight.entries;
+    }
+
+    /**
+     *
+     * @param id
+     * @return the first position where the phrase can be counted again, matchers may skip to it
+     */
+    size_t next(int id) const
+    {
+        size_t next = _stored(id);
+        return next > _offset ? next - _offset : 0;
+    }
+
+    /**
+     *
+     * @param offset the position in the text of position 0 of the next reports
+     */
+    void setOffset(size_t offset)
+    {
+        _offset = offset;
+    }
+
+    /**
+     *
+     * @return a segment counter with the weights and the offset of this counter, for add()
+     */
+    MatchCounter segment() const
+    {
+        MatchCounter segment(_weights, true);
+        segment.setOffset(_offset);
+        return segment;
+    }
+
+    /**
+     * counts a segment as if its occurrences were reported here. Where the first occurrence of a phrase in the
+     * segment starts before this counter lets it, the segment counted a different chain of that phrase - the two
+     * chains are followed through the text with a find loop until they meet, and the difference is counted.
+     * @param segment a segment() counter of this counter that counted [begin, end) of text
+     * @param text the text, as this counter's positions see it
+     * @param size
+     * @param begin
+     * @param end
+     * @return the number of phrases that had to be followed through the text
+     */
+    size_t add(const MatchCounter &segment, const char *text, size_t size, size_t begin, size_t end)
+    {
+        _points += segment._points;
+        _matches += segment._matches;
+        size_t rescans = 0;
+        for (const std::pair<int, size_t> &touched : segment._touched)
+        {
+            int id = touched.first;
+            size_t first = touched.second - _offset;
+            size_t entering = next(id);
+            if (first >= entering)
+            {
+                // the segment counted the same chain as a serial scan
+                _store(id, segment._stored(id));
+                continue;
+            }
+            ++rescans;
+            _follow(id, std::string_view(text, size), first, entering, begin, end, segment._stored(id));
+        }
+        return rescans;
+    }
+
+    /**
+     *
+     * @return
+     */
+    double points() const
+    {
+        return _points;
+    }
+
+    /**
+     *
+     * @return
+     */
+    int matches() const
+    {
+        return _matches;
+    }
+
+private:
+    const std::vector<PhraseWeight> &_weights;
+    bool _dense;
+    bool _segment;
+    std::vector<size_t> _next;
+    // the phrases a segment counter counted, with the position of their first counted occurrence
+    std::vector<std::pair<int, size_t>> _touched;
+    size_t _offset = 0;
+    HashMap<int, size_t> _sparse;
+    double _points = 0;
+    int _matches = 0;
+
+    /**
+     *
+     * @param id
+     * @return the end of the last counted occurrence of the phrase in text positions, 0 if none was counted
+     */
+    size_t _stored(int id) const
+    {
+        if (_dense)
+        {
+            return _next[id];
+        }
+        return _sparse.containsKey(id) ? _sparse.at(id) : 0;
+    }
+
+    /**
+     *
+     * @param id
+     * @param next
+     */
+    void _store(int id, size_t next)
+    {
+        if (_dense)
+        {
+            _next[id] = next;
+        }
+        else
+        {
+            _sparse[id] = next;
+        }
+    }
+
+    /**
+     * replaces the chain a segment counted for a phrase with the chain that starts at entering - both chains are
+     * walked with a find loop, the one behind first, until they reach the same occurrence and go on as one, or the
+     * end of the segment
+     * @param id
+     * @param text
+     * @param first the first occurrence the segment counted, the phrase is the text there
+     * @param entering where this counter lets the phrase be counted again, after first
+     * @param begin
+     * @param end
+     * @param segmentNext what the segment stored for the phrase, in text positions
+     */
+    void _follow(int id, std::string_view text, size_t first, size_t entering, size_t begin, size_t end,
+                 size_t segmentNext)
+    {
+        const PhraseWeight &weight = _weights[id];
+        // an occurrence that starts before end ends at most length - 1 chars after it
+        text = text.substr(0, std::min(text.size(), end + weight.length - 1));
+        std::string_view phrase = text.substr(first, weight.length);
+        size_t segmentChain = first;
+        size_t chain = text.find(phrase, std::max(entering, begin));
+        long difference = 0;
+        size_t last = std::string_view::npos;
+        while (chain < end || segmentChain < end)
+        {
+            if (chain == segmentChain)
+            {
+                // from here on the segment's chain is the right one
+                _count(weight, difference);
+                _store(id, segmentNext);
+                return;
+            }
+            if (chain < segmentChain)
+            {
+                last = chain;
+                ++difference;
+                chain = text.find(phrase, chain + weight.length);
+            }
+            else
+            {
+                --difference;
+                segmentChain = text.find(phrase, segmentChain + weight.length);
+            }
+        }
+        _count(weight, difference);
+        if (last != std::string_view::npos)
+        {
+            _store(id, last + weight.length + _offset);
+        }
+    }
+
+    /**
+     *
+     * @param weight
+     * @param occurrences the number of occurrences to add, negative to take them back
+     */
+    void _count(const PhraseWeight &weight, long occurrences)
+    {
+        _points += (double) weight.points * occurrences;
+        _matches += (int) (weight.entries * occurrences);
+    }
+};
+
+/**
+ * what the automatic engine selection knows about a dictionary - only the phrase count and the phrase lengths decide
+ * between the engines
+ */
+struct DictionaryStats
+{
+    size_t phrases = 0;
+    size_t minLength = 0;
+    size_t maxLength = 0;
+
+    /**
+     *
+     * @param phrases
+     * @return
+     */
+    static DictionaryStats of(const std::vector<Phrase> &phrases)
+    {
+        DictionaryStats stats;
+        stats.phrases = phrases.size();
+        for (const Phrase &phrase : phrases)
+        {
+            size_t length = phrase.text.size();
+            stats.minLength = stats.minLength == 0 ? length : std::min(stats.minLength, length);
+            stats.maxLength = std::max(stats.maxLength, length);
+        }
+        return stats;
+    }
+};
+
+/**
+ * A multi phrase search engine. It is built once from the phrases and is read only afterwards, so one matcher can
+ * scan many texts at once.
+ */
+class Matcher
+{
+public:
+    /**
+     *
+     */
+    virtual ~Matcher() = default;
+
+    /**
+     *
+     * @return the name --engine selects it by
+     */
+    virtual const char *name() const = 0;
+
+    /**
+     *
+     * @param phrases the phrases, their index is the id scan reports
+     */
+    virtual void build(const std::vector<Phrase> &phrases) = 0;
+
+    /**
+     * reports every occurrence of every phrase that starts in [begin, end) - occurrences may end after end, as
+     * long as they end inside the text. The occurrences of one phrase are reported in increasing order.
+     * @param text lower case text
+     * @param size
+     * @param begin
+     * @param end
+     * @param counter
+     */
+    virtual void scan(const char *text, size_t size, size_t begin, size_t end, MatchCounter &counter) const = 0;
+
+    /**
+     * writes engine specific statistics
+     * @param out
+     */
+    virtual void printStats(std::ostream &out) const
+    {
+        (void) out;
+    }
+
+    /**
+     * forgets the statistics of the scans so far
+     */
+    virtual void resetStats()
+    {
+    }
+};
+
+#endif
@@ -0,0 +1,231 @@
+#include <chrono>
+#include <memory>
+#include "Matcher.hpp"
+#include "FindMatcher.hpp"
+#include "LookupMatcher.hpp"
+#include "TeddyMatcher.hpp"
+#include "TrieMatcher.hpp"
+
+#ifndef MATCHERFACTORY
+#define MATCHERFACTORY
+
+#define AUTO_ENGINE "auto"
+#define CALIBRATE_ENGINE "calibrate"
+#define TRIE_MIN_PHRASES 64
+#define TEDDY_MAX_PHRASES 512
+#define TEDDY_MIN_LENGTH 2
+#define CALIBRATION_BYTES (1 << 16)
+#define CALIBRATION_PHRASE_GAP 256
+#define CALIBRATION_ROUNDS 3
+#define CALIBRATION_SLICE (1 << 12)
+
+/**
+ * Knows the matchers, and picks one for a dictionary - from its phrase count and phrase lengths (auto), or by timing
+ * the engines on a sample text made of the dictionary's own chars and phrases (calibrate).
+ */
+class MatcherFactory
+{
+public:
+    /**
+     *
+     * @return the names of the engines
+     */
+    static const std::vector<std::string> &engines()
+    {
+        static const std::vector<std::string> names = {"find", "teddy", "lookup", "trie"};
+        return names;
+    }
+
+    /**
+     *
+     * @param engine
+     * @return true iff engine is a known engine, "auto" or "calibrate"
+     */
+    static bool isEngine(const std::string &engine)
+    {
+        return engine == AUTO_ENGINE || engine == CALIBRATE_ENGINE ||
+               std::find(engines().begin(), engines().end(), engine) != engines().end();
+    }
+
+    /**
+     *
+     * @param engine
+     * @return an unbuilt matcher, nullptr for an unknown engine
+     */
+    static std::unique_ptr<Matcher> make(const std::string &engine)
+    {
+        if (engine == "find")
+        {
+            return std::unique_ptr<Matcher>(new FindMatcher());
+        }
+        if (engine == "lookup")
+        {
+            return std::unique_ptr<Matcher>(new LookupMatcher());
+        }
+        if (engine == "teddy")
+        {
+            return std::unique_ptr<Matcher>(new TeddyMatcher());
+        }
+        if (engine == "trie")
+        {
+            return std::unique_ptr<Matcher>(new TrieMatcher());
+        }
+        return nullptr;
+    }
+
+    /**
+     *
+     * @param stats
+     * @return the engine that should do best on such a dictionary - never "lookup", its window lookups lose to the
+     * trie at every size, it is only there for --engine=lookup and calibration
+     */
+    static std::string choose(const DictionaryStats &stats)
+    {
+        // teddy needs two fingerprint bytes to be selective, and few enough phrases for its 8 buckets
+        if (stats.phrases <= TEDDY_MAX_PHRASES && stats.minLength >= TEDDY_MIN_LENGTH)
+        {
+            return "teddy";
+        }
+        // a find per phrase is hard to beat for a few phrases, after that the trie walk doesn't grow with them
+        if (stats.phrases < TRIE_MIN_PHRASES)
+        {
+            return "find";
+        }
+        return "trie";
+    }
+
+    /**
+     *
+     * @param engine an engine, "auto" or "calibrate"
+     * @param phrases
+     * @return a matcher built for the phrases
+     */
+    static std::unique_ptr<Matcher> build(const std::string &engine, const std::vector<Phrase> &phrases)
+    {
+        if (engine == CALIBRATE_ENGINE)
+        {
+            return calibrate(phrases);
+        }
+        std::unique_ptr<Matcher> matcher = make(engine == AUTO_ENGINE ? choose(DictionaryStats::of(phrases)) : engine);
+        if (matcher == nullptr)
+        {
+            throw std::invalid_argument("unknown engine " + engine);
+        }
+        matcher->build(phrases);
+        return matcher;
+    }
+
+    /**
+     * builds the engines and keeps the one that scans the sample text fastest - the engine auto would choose is
+     * timed first, and every other engine is given up as soon as it took longer than the fastest so far, so an
+     * engine that can't win (a find per phrase of a large dictionary) costs no more than the winner
+     * @param phrases
+     * @return the winner, with the statistics of the timing scans reset
+     */
+    static std::unique_ptr<Matcher> calibrate(const std::vector<Phrase> &phrases)
+    {
+        std::string sample = calibrationText(phrases);
+        std::vector<PhraseWeight> weights = PhraseWeight::of(phrases);
+        std::string chosen = choose(DictionaryStats::of(phrases));
+        std::vector<std::string> order = {chosen};
+        for (const std::string &engine : engines())
+        {
+            if (engine != chosen)
+            {
+                order.push_back(engine);
+            }
+        }
+        std::unique_ptr<Matcher> best;
+        double bestTime = 0;
+        for (const std::string &engine : order)
+        {
+            std::unique_ptr<Matcher> matcher = make(engine);
+            matcher->build(phrases);
+            double time = 0;
+            for (int round = 0; round < CALIBRATION_ROUNDS; ++round)
+            {
+                double took = timeScan(*matcher, weights, sample, best == nullptr ? 0 : bestTime);
+                time = round == 0 ? took : std::min(time, took);
+                if (best != nullptr && time > bestTime)
+                {
+                    break;
+                }
+            }
+            if (best == nullptr || time < bestTime)
+            {
+                best = std::move(matcher);
+                bestTime = time;
+            }
+        }
+        best->resetStats();
+        return best;
+    }
+
+private:
+    /**
+     * scans the sample a slice at a time
+     * @param matcher
+     * @param weights
+     * @param sample
+     * @param limit the scan is given up once it took longer, 0 for no limit
+     * @return the time of the scan, more than limit if it was given up
+     */
+    static double timeScan(const Matcher &matcher, const std::vector<PhraseWeight> &weights, const std::string &sample,
+                           double limit)
+    {
+        MatchCounter counter(weights);
+        auto start = std::chrono::steady_clock::now();
+        std::chrono::duration<double> took(0);
+        for (size_t begin = 0; begin < sample.size(); begin += CALIBRATION_SLICE)
+        {
+            matcher.scan(sample.data(), sample.size(), begin, std::min(sample.size(), begin + CALIBRATION_SLICE),
+                         counter);
+            took = std::chrono::steady_clock::now() - start;
+            if (limit > 0 && took.count() > limit)
+            {
+                break;
+            }
+        }
+        return took.count();
+    }
+
+    /**
+     *
+     * @param phrases
+     * @return chars drawn from the phrases, with a whole phrase every CALIBRATION_PHRASE_GAP chars
+     */
+    static std::string calibrationText(const std::vector<Phrase> &phrases)
+    {
+        std::string chars;
+        for (const Phrase &phrase : phrases)
+        {
+            chars += phrase.text;
+            if (chars.size() >= CALIBRATION_BYTES)
+            {
+                break;
+            }
+        }
+        if (chars.empty())
+        {
+            chars = " ";
+        }
+        std::string text;
+        text.reserve(CALIBRATION_BYTES);
+        uint64_t state = 0x9e3779b97f4a7c15ULL;
+        while (text.size() < CALIBRATION_BYTES)
+        {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            if (!phrases.empty() && (state >> 33) % CALIBRATION_PHRASE_GAP == 0)
+            {
+                text += phrases[(state >> 17) % phrases.size()].text;
+            }
+            else
+            {
+                text += chars[(state >> 33) % chars.size()];
+            }
+        }
+        return text;
+    }
+};
+
+#endif
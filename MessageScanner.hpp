@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <string>
+#include <vector>
+#include "Matcher.hpp"
+
+#ifndef MESSAGESCANNER
+#define MESSAGESCANNER
+
+#define SCAN_WINDOW (1 << 16)
+
+/**
+ * Scores a message that arrives in pieces, without holding all of it. The message is lower-cased into a window
+ * of SCAN_WINDOW bytes; when the window is full, the positions that a phrase could still start at with the next
+ * piece (the last longest phrase length - 1 bytes) stay, and everything before them is scanned and dropped.
+ * The window is framed like the message of SpamDetector::setMessage (a space before, a new line after), so the
+ * score is the one SpamDetector gives the same content.
+ */
+class MessageScanner
+{
+public:
+    /**
+     *
+     * @param matcher a built matcher, it must outlive the scanner
+     * @param weights the weights of the matcher's phrases
+     * @param maxLength the length of the longest phrase
+     */
+    MessageScanner(const Matcher &matcher, const std::vector<PhraseWeight> &weights, size_t maxLength) :
+            _matcher(matcher), _counter(weights), _keep(std::max<size_t>(maxLength, 1) - 1)
+    {
+        _window.reserve(SCAN_WINDOW + _keep);
+        _window.push_back(' ');
+    }
+
+    /**
+     * adds the next piece of the message
+     * @param data
+     * @param size
+     */
+    void feed(const char *data, size_t size)
+    {
+        _fed += size;
+        while (size > 0)
+        {
+            size_t room = SCAN_WINDOW + _keep - _window.size();
+            size_t piece = std::min(room, size);
+            // the window has the room reserved, so this only moves its end
+            size_t at = _window.size();
+            _window.resize(at + piece);
+            const unsigned char *lower = lowerCase();
+            std::transform(data, data + piece, &_window[at], [lower](char c)
+            { return (char) lower[(unsigned char) c]; });
+            data += piece;
+            size -= piece;
+            if (_window.size() == SCAN_WINDOW + _keep)
+            {
+                _scan(_window.size() - _keep);
+            }
+        }
+    }
+
+    /**
+     * scans the rest of the message, nothing can be fed after it
+     */
+    void finish()
+    {
+        if (_finished)
+        {
+            return;
+        }
+        _finished = true;
+        // an empty message isn't scanned at all, as in SpamDetector::scoreMessage
+        if (_fed == 0)
+        {
+            return;
+        }
+        _window.push_back('\n');
+        _scan(_window.size());
+    }
+
+    /**
+     *
+     * @return the points counted so far
+     */
+    double points() const
+    {
+        return _counter.points();
+    }
+
+    /**
+     *
+     * @return the number of occurrences counted so far
+     */
+    int matches() const
+    {
+        return _counter.matches();
+    }
+
+private:
+    const Matcher &_matcher;
+    MatchCounter _counter;
+    size_t _keep;
+    std::string _window;
+    // the position of the window in the framed message
+    size_t _offset = 0;
+    size_t _fed = 0;
+    bool _finished = false;
+
+    /**
+     * std::tolower looks the locale up for every char, so its results are taken once
+     * @return the lower case of every byte
+     */
+    static const unsigned char *lowerCase()
+    {
+        static const std::array<unsigned char, 256> table = []
+        {
+            std::array<unsigned char, 256> lower{};
+            for (int c = 0; c < 256; ++c)
+            {
+                lower[c] = (unsigned char) std::tolower(c);
+            }
+            return lower;
+        }();
+        return table.data();
+    }
+
+    /**
+     * counts the occurrences that start before end, and drops the window up to end
+     * @param end
+     */
+    void _scan(size_t end)
+    {
+        _counter.setOffset(_offset);
+        _matcher.scan(_window.data(), _window.size(), 0, end, _counter);
+        _window.erase(0, end);
+        _offset += end;
+    }
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "Matcher.hpp"
+
+#ifndef PARALLELSCANNER
+#define PARALLELSCANNER
+
+#define DEFAULT_PARALLEL_THRESHOLD (4 << 20)
+#define MIN_SEGMENT (1 << 18)
+
+/**
+ * Scans one large text on several threads. The text is cut into segments, and each segment is scanned for the
+ * occurrences that start in it, reading at most the longest phrase length - 1 chars into the next segment. Every
+ * segment is counted on its own thread as if it started the text, then the segments are added one after the
+ * other: only a phrase whose first occurrence in a segment overlaps an occurrence counted at the end of the
+ * segment before is followed again through the text, so the score is exactly the one of a serial scan.
+ */
+class ParallelScanner
+{
+public:
+    /**
+     *
+     * @param threshold texts shorter than this are scanned on the calling thread, 0 never scans in parallel
+     * @param threads the number of segments at most, 0 for one per core
+     * @param minSegment segments are at least this long
+     */
+    explicit ParallelScanner(size_t threshold = DEFAULT_PARALLEL_THRESHOLD, unsigned int threads = 0,
+                             size_t minSegment = MIN_SEGMENT) :
+            _threshold(threshold), _threads(threads == 0 ? std::thread::hardware_concurrency() : threads),
+            _minSegment(std::max<size_t>(minSegment, 1))
+    {
+        _threads = std::max(_threads, 1u);
+    }
+
+    /**
+     *
+     * @param threshold
+     */
+    void setThreshold(size_t threshold)
+    {
+        _threshold = threshold;
+    }
+
+    /**
+     * counts the occurrences of the phrases in text
+     * @param matcher
+     * @param maxLength the length of the longest phrase
+     * @param text lower case text
+     * @param size
+     * @param counter
+     */
+    void scan(const Matcher &matcher, size_t maxLength, const char *text, size_t size, MatchCounter &counter) const
+    {
+        size_t segments = std::min<size_t>(_threads, size / _minSegment);
+        if (_threshold == 0 || size < _threshold || segments < 2)
+        {
+            matcher.scan(text, size, 0, size, counter);
+            return;
+        }
+        size_t length = (size + segments - 1) / segments;
+        std::vector<MatchCounter> found(segments, counter.segment());
+        auto scanSegment = [&](size_t k)
+        {
+            size_t begin = k * length;
+            size_t end = std::min(size, begin + length);
+            // the overlap - an occurrence that starts before end may reach maxLength - 1 chars past it
+            size_t visible = std::min(size, end + std::max<size_t>(maxLength, 1) - 1);
+            matcher.scan(text, visible, begin, end, found[k]);
+        };
+        std::vector<std::thread> workers;
+        for (size_t k = 1; k < segments; ++k)
+        {
+            workers.emplace_back(scanSegment, k);
+        }
+        scanSegment(0);
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+        for (size_t k = 0; k < segments; ++k)
+        {
+            _rescans += counter.add(found[k], text, size, k * length, std::min(size, (k + 1) * length));
+        }
+        ++_parallelScans;
+    }
+
+    /**
+     *
+     * @return the number of texts that were scanned in segments
+     */
+    unsigned long parallelScans() const
+    {
+        return _parallelScans;
+    }
+
+    /**
+     *
+     * @return the number of phrases that were followed again through a segment, because their first occurrence
+     * in it overlapped the segment before
+     */
+    unsigned long rescans() const
+    {
+        return _rescans;
+    }
+
+private:
+    size_t _threshold;
+    unsigned int _threads;
+    size_t _minSegment;
+    mutable std::atomic<unsigned long> _parallelScans{0};
+    mutable std::atomic<unsigned long> _rescans{0};
+};
+
+#endif
@@ -0,0 +1,78 @@
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "MatcherFactory.hpp"
+#include "ParallelScanner.hpp"
+#include "TestData.hpp"
+
+/**
+ * scans a text serially and in segments with every engine and compares the counts
+ * @param name
+ * @param phrases
+ * @param message
+ * @param minSegment
+ * @return true iff every segmented scan counted what the serial scan did
+ */
+bool check(const std::string &name, const std::vector<Phrase> &phrases, const std::string &message,
+           size_t minSegment)
+{
+    std::vector<PhraseWeight> weights = PhraseWeight::of(phrases);
+    size_t maxLength = DictionaryStats::of(phrases).maxLength;
+    bool ok = true;
+    for (const std::string &engine : MatcherFactory::engines())
+    {
+        std::unique_ptr<Matcher> matcher = MatcherFactory::make(engine);
+        matcher->build(phrases);
+        MatchCounter serial(weights);
+        matcher->scan(message.data(), message.size(), 0, message.size(), serial);
+        for (unsigned int threads : {2, 3, 7, 16})
+        {
+            ParallelScanner scanner(1, threads, minSegment);
+            MatchCounter counter(weights);
+            scanner.scan(*matcher, maxLength, message.data(), message.size(), counter);
+            if (counter.points() != serial.points() || counter.matches() != serial.matches())
+            {
+                std::cerr << name << ", " << engine << ", " << threads << " threads: counted " << counter.points()
+                          << " / " << counter.matches() << " instead of " << serial.points() << " / "
+                          << serial.matches() << std::endl;
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+/**
+ *
+ * @return
+ */
+int main()
+{
+    std::mt19937 random(34);
+    bool ok = true;
+    // a phrase that overlaps itself everywhere, so its chains on both sides of every border differ
+    ok &= check("one letter", {{"a", 1, 1}, {"aa", 2, 1}, {"aaa", 5, 2}}, std::string(10007, 'a'), 100);
+    ok &= check("two letters", {{"ab", 1, 1}, {"aba", 3, 1}, {"abab", 7, 1}, {"b", 1, 1}},
+                TestData::text(random, "ab", 20011), 64);
+    // chains that meet again after a few occurrences, and ones that never do
+    std::string periodic;
+    while (periodic.size() < 30000)
+    {
+        periodic += random() % 4 == 0 ? "xaaaaaaa" : "aaaa";
+    }
+    ok &= check("chains that meet", {{"aa", 1, 1}, {"aaa", 1, 1}, {"xa", 1, 1}}, periodic, 97);
+    // phrases longer than a segment
+    ok &= check("long phrases", {{std::string(150, 'a'), 4, 1}, {"a", 1, 1}}, std::string(5000, 'a'), 100);
+    for (int round = 0; round < 20; ++round)
+    {
+        std::string alphabet = round % 2 == 0 ? "ab" : "abc d";
+        size_t count = round < 10 ? 1 + random() % 30 : DENSE_COUNTER_MAX + 10;
+        std::vector<Phrase> phrases = TestData::dictionary(random, alphabet, count, 12);
+        ok &= check("random " + std::to_string(round), phrases,
+                    TestData::text(random, alphabet, 4000 + random() % 20000), 1 + random() % 500);
+    }
+    std::cout << (ok ? "passed" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
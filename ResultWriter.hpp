@@ -0,0 +1,187 @@
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#ifndef RESULTWRITER
+#define RESULTWRITER
+
+#define RESULT_BLOCK (1 << 16)
+#define SPAM_MESSAGE "SPAM"
+#define NOT_SPAM_MESSAGE "NOT_SPAM"
+
+/**
+ * the outcome of scoring one message
+ */
+struct Result
+{
+    std::string id;
+    double score;
+    bool spam;
+    int matches;
+};
+
+/**
+ * Buffers verdicts and writes them in blocks of RESULT_BLOCK bytes, either as "<id> <verdict>" lines or as
+ * NDJSON records. Results may arrive from many threads in any order, they are written by their sequence number.
+ */
+class ResultWriter
+{
+public:
+    /**
+     *
+     * @param out
+     * @param json true for NDJSON records
+     */
+    ResultWriter(std::ostream &out, bool json) : _out(out), _json(json)
+    {
+        _buffer.reserve(RESULT_BLOCK);
+    }
+
+    ResultWriter(const ResultWriter &) = delete;
+
+    ResultWriter &operator=(const ResultWriter &) = delete;
+
+    /**
+     * dtor - writes what is still buffered
+     */
+    ~ResultWriter()
+    {
+        flush();
+    }
+
+    /**
+     *
+     * @param sequence the position of the result in the output, every sequence number must be written or skipped
+     * @param result
+     */
+    void write(size_t sequence, const Result &result)
+    {
+        _add(sequence, format(result));
+    }
+
+    /**
+     * gives up a sequence number that has no result
+     * @param sequence
+     */
+    void skip(size_t sequence)
+    {
+        _add(sequence, std::string());
+    }
+
+    /**
+     * writes the buffer to the stream
+     */
+    void flush()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _drain();
+        _out.flush();
+    }
+
+    /**
+     *
+     * @param result
+     * @return the line that is written for the result
+     */
+    std::string format(const Result &result) const
+    {
+        const char *verdict = result.spam ? SPAM_MESSAGE : NOT_SPAM_MESSAGE;
+        std::string line;
+        if (!_json)
+        {
+            if (!result.id.empty())
+            {
+                line = result.id + " ";
+            }
+            return line + verdict + "\n";
+        }
+        char number[32];
+        snprintf(number, sizeof(number), "%.17g", result.score);
+        line = "{\"id\":\"";
+        escape(result.id, line);
+        line += "\",\"score\":";
+        line += number;
+        line += ",\"verdict\":\"";
+        line += verdict;
+        line += "\",\"matches\":";
+        line += std::to_string(result.matches);
+        line += "}\n";
+        return line;
+    }
+
+private:
+    std::ostream &_out;
+    bool _json;
+    std::mutex _mutex;
+    std::string _buffer;
+    size_t _next = 0;
+    std::map<size_t, std::string> _waiting;
+
+    /**
+     * appends the line if its turn has come, together with the lines that waited for it
+     * @param sequence
+     * @param line
+     */
+    void _add(size_t sequence, std::string line)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (sequence != _next)
+        {
+            _waiting.emplace(sequence, std::move(line));
+            return;
+        }
+        _buffer += line;
+        ++_next;
+        for (auto it = _waiting.begin(); it != _waiting.end() && it->first == _next; it = _waiting.erase(it))
+        {
+            _buffer += it->second;
+            ++_next;
+        }
+        if (_buffer.size() >= RESULT_BLOCK)
+        {
+            _drain();
+        }
+    }
+
+    /**
+     * writes the buffer, the caller holds the lock
+     */
+    void _drain()
+    {
+        _out.write(_buffer.data(), (std::streamsize) _buffer.size());
+        _buffer.clear();
+    }
+
+    /**
+     * appends s as the inside of a json string
+     * @param s
+     * @param out
+     */
+    static void escape(const std::string &s, std::string &out)
+    {
+        static const char hex[] = "0123456789abcdef";
+        for (char c : s)
+        {
+            auto u = (unsigned char) c;
+            if (c == '"' || c == '\\')
+            {
+                out += '\\';
+                out += c;
+            }
+            else if (u < 0x20)
+            {
+                out += "\\u00";
+                out += hex[u >> 4];
+                out += hex[u & 0xf];
+            }
+            else
+            {
+                out += c;
+            }
+        }
+    }
+};
+
+#endif
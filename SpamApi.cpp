@@ -0,0 +1,288 @@
+#include <fstream>
+#include <sstream>
+#include "SpamApi.h"
+#include "SpamDetector.hpp"
+
+/**
+ * a loaded database - only the matcher and the weights of its SpamDetector are used after loading, and they are
+ * read only. The verdicts of spamScore are cached here, shared by every thread that scores with the dictionary.
+ */
+struct SpamDictionary
+{
+    // the detector's own msg, never used by the library
+    std::string message;
+    SpamDetector detector;
+    double threshold;
+    // by the digest of the message as it was given, seeded with the detector's version
+    mutable VerdictCache cache;
+
+    /**
+     *
+     * @param threshold
+     */
+    explicit SpamDictionary(double threshold) : detector(threshold, 0, message), threshold(threshold)
+    {}
+};
+
+/**
+ *
+ */
+struct SpamStream
+{
+    const SpamDictionary *dictionary;
+    MessageScanner scanner;
+    bool finished = false;
+};
+
+/**
+ * loads the dictionary from a database stream, the exceptions of the detector become status codes
+ * @param database
+ * @param threshold
+ * @param engine
+ * @param dictionary
+ * @return
+ */
+static SpamStatus load(std::istream &database, double threshold, const char *engine, SpamDictionary **dictionary)
+{
+    if (dictionary == nullptr || !(threshold > 0) || (engine != nullptr && !MatcherFactory::isEngine(engine)))
+    {
+        return SPAM_ERROR_ARGUMENT;
+    }
+    *dictionary = nullptr;
+    try
+    {
+        std::unique_ptr<SpamDictionary> loaded(new SpamDictionary(threshold));
+        loaded->detector.setEngine(engine == nullptr ? AUTO_ENGINE : engine);
+        loaded->detector.loadDataBase(database);
+        *dictionary = loaded.release();
+        return SPAM_OK;
+    }
+    catch (const hashExceptions &)
+    {
+        return SPAM_ERROR_DATABASE;
+    }
+    catch (const std::logic_error &)
+    {
+        // points that std::stoi can't convert
+        return SPAM_ERROR_DATABASE;
+    }
+    catch (const std::bad_alloc &)
+    {
+        return SPAM_ERROR_MEMORY;
+    }
+    catch (...)
+    {
+        return SPAM_ERROR_INTERNAL;
+    }
+}
+
+/**
+ *
+ * @param dictionary
+ * @param verdict
+ * @param result
+ */
+static void fill(const SpamDictionary *dictionary, const Verdict &verdict, SpamResult *result)
+{
+    result->score = verdict.score;
+    result->matches = verdict.matches;
+    result->spam = result->score >= dictionary->threshold;
+}
+
+/**
+ *
+ * @param scanner a finished scanner
+ * @return
+ */
+static Verdict verdictOf(const MessageScanner &scanner)
+{
+    return Verdict{scanner.points(), scanner.matches()};
+}
+
+SpamStatus spamDictionaryLoad(const char *path, double threshold, const char *engine, SpamDictionary **dictionary)
+{
+    if (path == nullptr)
+    {
+        return SPAM_ERROR_ARGUMENT;
+    }
+    std::ifstream database(path, std::fstream::in);
+    if (!database.is_open())
+    {
+        return SPAM_ERROR_IO;
+    }
+    return load(database, threshold, engine, dictionary);
+}
+
+SpamStatus spamDictionaryCompile(const char *database, size_t size, double threshold, const char *engine,
+                                 SpamDictionary **dictionary)
+{
+    if (database == nullptr && size > 0)
+    {
+        return SPAM_ERROR_ARGUMENT;
+    }
+    try
+    {
+        std::istringstream stream(std::string(database == nullptr ? "" : database, size));
+        return load(stream, threshold, engine, dictionary);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return SPAM_ERROR_MEMORY;
+    }
+}
+
+void spamDictionaryFree(SpamDictionary *dictionary)
+{
+    delete dictionary;
+}
+
+SpamStatus spamScore(const SpamDictionary *dictionary, const char *message, size_t size, SpamResult *result)
+{
+    if (dictionary == nullptr || result == nullptr || (message == nullptr && size > 0))
+    {
+        return SPAM_ERROR_ARGUMENT;
+    }
+    try
+    {
+        Digest digest{0, 0};
+        Verdict verdict{0, 0};
+        if (dictionary->cache.enabled())
+        {
+            digest = Digest::of(message, size, dictionary->detector.version());
+            if (dictionary->cache.find(digest, verdict))
+            {
+                fill(dictionary, verdict, result);
+                return SPAM_OK;
+            }
+        }
+        MessageScanner scanner = dictionary->detector.scanner();
+        scanner.feed(message, size);
+        scanner.finish();
+        verdict = verdictOf(scanner);
+        dictionary->cache.insert(digest, verdict);
+        fill(dictionary, verdict, result);
+        return SPAM_OK;
+    }
+    catch (const std::bad_alloc &)
+    {
+        return SPAM_ERROR_MEMORY;
+    }
+    catch (...)
+    {
+        return SPAM_ERROR_INTERNAL;
+    }
+}
+
+SpamStatus spamDictionarySetCacheSize(SpamDictionary *dictionary, size_t entries)
+{
+    if (dictionary == nullptr)
+    {
+        return SPAM_ERROR_ARGUMENT;
+    }
+    try
+    {
+        dictionary->cache.setCapacity(entries);
+        return SPAM_OK;
+    }
+    catch (const std::bad_alloc &)
+    {
+        return SPAM_ERROR_MEMORY;
+    }
+}
+
+SpamStatus spamDictionaryCacheStats(const SpamDictionary *dictionary, unsigned long *hits, unsigned long *misses)
+{
+    if (dictionary == nullptr || hits == nullptr || misses == nullptr)
+    {
+        return SPAM_ERROR_ARGUMENT;
+    }
+    *hits = dictionary->cache.hits();
+    *misses = dictionary->cache.misses();
+    return SPAM_OK;
+}
+
+SpamStatus spamStreamOpen(const SpamDictionary *dictionary, SpamStream **stream)
+{
+    if (dictionary == nullptr || stream == nullptr)
+    {
+        return SPAM_ERROR_ARGUMENT;
+    }
+    try
+    {
+        *stream = new SpamStream{dictionary, dictionary->detector.scanner()};
+        return SPAM_OK;
+    }
+    catch (const std::bad_alloc &)
+    {
+        return SPAM_ERROR_MEMORY;
+    }
+}
+
+SpamStatus spamStreamFeed(SpamStream *stream, const char *data, size_t size)
+{
+    if (stream == nullptr || stream->finished || (data == nullptr && size > 0))
+    {
+        return SPAM_ERROR_ARGUMENT;
+    }
+    try
+    {
+        stream->scanner.feed(data, size);
+        return SPAM_OK;
+    }
+    catch (const std::bad_alloc &)
+    {
+        return SPAM_ERROR_MEMORY;
+    }
+    catch (...)
+    {
+        return SPAM_ERROR_INTERNAL;
+    }
+}
+
+SpamStatus spamStreamFinish(SpamStream *stream, SpamResult *result)
+{
+    if (stream == nullptr || result == nullptr)
+    {
+        return SPAM_ERROR_ARGUMENT;
+    }
+    try
+    {
+        stream->scanner.finish();
+        stream->finished = true;
+        fill(stream->dictionary, verdictOf(stream->scanner), result);
+        return SPAM_OK;
+    }
+    catch (const std::bad_alloc &)
+    {
+        return SPAM_ERROR_MEMORY;
+    }
+    catch (...)
+    {
+        return SPAM_ERROR_INTERNAL;
+    }
+}
+
+void spamStreamFree(SpamStream *stream)
+{
+    delete stream;
+}
+
+const char *spamStatusMessage(SpamStatus status)
+{
+    switch (status)
+    {
+        case SPAM_OK:
+            return "ok";
+        case SPAM_ERROR_ARGUMENT:
+            return "invalid argument";
+        case SPAM_ERROR_IO:
+            return "the database can't be read";
+        case SPAM_ERROR_DATABASE:
+            return "invalid database";
+        case SPAM_ERROR_MEMORY:
+            return "out of memory";
+        case SPAM_ERROR_INTERNAL:
+            return "internal error";
+    }
+    return "unknown status";
+}
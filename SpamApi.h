@@ -0,0 +1,315 @@
+#ifndef SPAMAPI
+#define SPAMAPI
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * what every function of the library returns
+ */
+typedef enum
+{
+    SPAM_OK = 0,
+    SPAM_ERROR_ARGUMENT,
+    SPAM_ERROR_IO,
+    SPAM_ERROR_DATABASE,
+    SPAM_ERROR_MEMORY,
+    SPAM_ERROR_INTERNAL
+} SpamStatus;
+
+/**
+ * the score of one message
+ */
+typedef struct
+{
+    double score;
+    int matches;
+    int spam;
+} SpamResult;
+
+/**
+ * a loaded database and its threshold - read only once loaded, one dictionary may score on many threads at once
+ */
+typedef struct SpamDictionary SpamDictionary;
+
+/**
+ * a message that is scored while it is fed in pieces, it belongs to one thread at a time
+ */
+typedef struct SpamStream SpamStream;
+
+/**
+ * loads a database file - the format of SpamDetector's database (phrase,points lines). An empty database is
+ * valid, every message scores 0 with it
+ * @param path
+ * @param threshold the score from which a message is spam, positive
+ * @param engine a search engine name, "auto", "calibrate", or NULL for "auto"
+ * @param dictionary set to the new dictionary on SPAM_OK
+ * @return
+ */
+SpamStatus spamDictionaryLoad(const char *path, double threshold, const char *engine, SpamDictionary **dictionary);
+
+/**
+ * like spamDictionaryLoad, from the content of a database file
+ * @param database
+ * @param size
+ * @param threshold
+ * @param engine
+ * @param dictionary
+ * @return
+ */
+SpamStatus spamDictionaryCompile(const char *database, size_t size, double threshold, const char *engine,
+                                 SpamDictionary **dictionary);
+
+/**
+ * frees a dictionary, no stream of it may be used afterwards
+ * @param dictionary may be NULL
+ */
+void spamDictionaryFree(SpamDictionary *dictionary);
+
+/**
+ * sets how many verdicts of spamScore the dictionary keeps (DEFAULT_CACHE_ENTRIES, 4096, until it is set) and drops
+ * the cached ones - it may not be called while other threads score with the dictionary
+ * @param dictionary
+ * @param entries 0 disables the cache
+ * @return
+ */
+SpamStatus spamDictionarySetCacheSize(SpamDictionary *dictionary, size_t entries);
+
+/**
+ *
+ * @param dictionary
+ * @param hits set to the number of spamScore calls answered from the cache
+ * @param misses set to the number of spamScore calls that had to scan
+ * @return
+ */
+SpamStatus spamDictionaryCacheStats(const SpamDictionary *dictionary, unsigned long *hits, unsigned long *misses);
+
+/**
+ * scores a message - the buffer is read in place and not kept. The verdict is cached by the content of the
+ * buffer, so a message that was already scored with the dictionary is not scanned again
+ * @param dictionary
+ * @param message
+ * @param size
+ * @param result
+ * @return
+ */
+SpamStatus spamScore(const SpamDictionary *dictionary, const char *message, size_t size, SpamResult *result);
+
+/**
+ * starts a message that will be fed in pieces
+ * @param dictionary
+ * @param stream set to the new stream on SPAM_OK
+ * @return
+ */
+SpamStatus spamStreamOpen(const SpamDictionary *dictionary, SpamStream **stream);
+
+/**
+ * adds the next piece of the message
+ * @param stream
+ * @param data
+ * @param size
+ * @return
+ */
+SpamStatus spamStreamFeed(SpamStream *stream, const char *data, size_t size);
+
+/**
+ * ends the message, nothing can be fed after it
+ * @param stream
+ * @param result the score of the whole message
+ * @return
+ */
+SpamStatus spamStreamFinish(SpamStream *stream, SpamResult *result);
+
+/**
+ * frees a stream, finished or not
+ * @param stream may be NULL
+ */
+void spamStreamFree(SpamStream *stream);
+
+/**
+ *
+ * @param status
+ * @return a description of status
+ */
+const char *spamStatusMessage(SpamStatus status);
+
+#ifdef __cplusplus
+}
+
+#include <stdexcept>
+#include <string>
+
+/**
+ * The C++ face of the library - owns a dictionary, and throws SpamError where the C functions return an error.
+ */
+class SpamError : public std::runtime_error
+{
+public:
+    /**
+     *
+     * @param status
+     */
+    explicit SpamError(SpamStatus status) : std::runtime_error(spamStatusMessage(status)), _status(status)
+    {}
+
+    /**
+     *
+     * @return
+     */
+    SpamStatus status() const
+    {
+        return _status;
+    }
+
+private:
+    SpamStatus _status;
+};
+
+/**
+ *
+ */
+class SpamFilter
+{
+public:
+    /**
+     * a message that is fed in pieces
+     */
+    class Stream
+    {
+    public:
+        /**
+         *
+         * @param filter
+         */
+        explicit Stream(const SpamFilter &filter)
+        {
+            check(spamStreamOpen(filter._dictionary, &_stream));
+        }
+
+        Stream(const Stream &) = delete;
+
+        Stream &operator=(const Stream &) = delete;
+
+        /**
+         *
+         */
+        ~Stream()
+        {
+            spamStreamFree(_stream);
+        }
+
+        /**
+         *
+         * @param data
+         * @param size
+         */
+        void feed(const char *data, size_t size)
+        {
+            check(spamStreamFeed(_stream, data, size));
+        }
+
+        /**
+         *
+         * @return
+         */
+        SpamResult finish()
+        {
+            SpamResult result;
+            check(spamStreamFinish(_stream, &result));
+            return result;
+        }
+
+    private:
+        SpamStream *_stream = nullptr;
+    };
+
+    /**
+     * loads a database file
+     * @param path
+     * @param threshold
+     * @param engine
+     */
+    SpamFilter(const std::string &path, double threshold, const std::string &engine = "auto")
+    {
+        check(spamDictionaryLoad(path.c_str(), threshold, engine.c_str(), &_dictionary));
+    }
+
+    SpamFilter(const SpamFilter &) = delete;
+
+    SpamFilter &operator=(const SpamFilter &) = delete;
+
+    /**
+     *
+     */
+    ~SpamFilter()
+    {
+        spamDictionaryFree(_dictionary);
+    }
+
+    /**
+     *
+     * @param entries the number of verdicts kept, 0 disables the cache
+     */
+    void setCacheSize(size_t entries)
+    {
+        check(spamDictionarySetCacheSize(_dictionary, entries));
+    }
+
+    /**
+     *
+     * @return the number of scores answered from the cache
+     */
+    unsigned long cacheHits() const
+    {
+        unsigned long hits;
+        unsigned long misses;
+        check(spamDictionaryCacheStats(_dictionary, &hits, &misses));
+        return hits;
+    }
+
+    /**
+     *
+     * @return the number of scores that had to scan
+     */
+    unsigned long cacheMisses() const
+    {
+        unsigned long hits;
+        unsigned long misses;
+        check(spamDictionaryCacheStats(_dictionary, &hits, &misses));
+        return misses;
+    }
+
+    /**
+     *
+     * @param message
+     * @param size
+     * @return
+     */
+    SpamResult score(const char *message, size_t size) const
+    {
+        SpamResult result;
+        check(spamScore(_dictionary, message, size, &result));
+        return result;
+    }
+
+private:
+    SpamDictionary *_dictionary = nullptr;
+
+    /**
+     * @param status
+     */
+    static void check(SpamStatus status)
+    {
+        if (status != SPAM_OK)
+        {
+            throw SpamError(status);
+        }
+    }
+};
+
+#endif
+
+#endif
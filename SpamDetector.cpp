@@ -1,233 +1,125 @@
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cstring>
 #include <boost/filesystem.hpp>
-#include <boost/tokenizer.hpp>
-#include "HashMap.hpp"
+#include "SpamDetector.hpp"
+#include "BatchReader.hpp"
+#include "MailboxReader.hpp"
+#include "ResultWriter.hpp"
 
-#define SPAM_MESSAGE "SPAM"
-#define NOT_SPAM_MESSAGE "NOT_SPAM"
 #define INVALID "Invalid input"
-#define WRONG_NUMBER_OF_PARAMETERS "Usage: SpamDetector <database path> <message path> <threshold>"
+#define WRONG_NUMBER_OF_PARAMETERS "Usage: SpamDetector <database path> <message path | spool or maildir directory | mbox path> <threshold> " \
+                                   "[--stats] [--inflight=N] [--mbox] [--format=plain|ndjson] " \
+                                   "[--engine=auto|calibrate|find|teddy|lookup|trie] [--parallel-threshold=BYTES] " \
+                                   "[--cache=ENTRIES]"
+#define EMBEDDED_DATABASE "embedded:"
+#define STATS_OPTION "--stats"
+#define IN_FLIGHT_OPTION "--inflight="
+#define MBOX_OPTION "--mbox"
+#define STANDARD_INPUT "-"
+#define FORMAT_OPTION "--format="
+#define PLAIN_FORMAT "plain"
+#define NDJSON_FORMAT "ndjson"
+#define ENGINE_OPTION "--engine="
+#define PARALLEL_THRESHOLD_OPTION "--parallel-threshold="
+#define CACHE_OPTION "--cache="
 
 /**
- *
+ * adds the messages of a maildir (new and cur, and the same for every maildir++ folder in it)
+ * @param maildir
+ * @param paths
  */
-class SpamDetector
+void maildirMessages(const boost::filesystem::path &maildir, std::vector<std::string> &paths)
 {
-private:
-    std::string _msg;
-    HashMap<std::string, std::string> _bad_words;
-    double _threshold;
-    double _badPoints;
-    bool _firstLine = true;
-public:
-    /**
-     *
-     * @param threshold
-     * @param points
-     * @param msg
-     */
-    SpamDetector(double threshold, double points, std::string &msg) : _msg(msg), _threshold(threshold),
-                                                                      _badPoints(points)
-    {
-        _bad_words = HashMap<std::string, std::string>();
-    }
-
-    /**
-     *
-     * @param line
-     */
-    void fromFileToHash(std::string &line)
+    for (const char *sub : {"new", "cur"})
     {
-        typedef boost::tokenizer<boost::escaped_list_separator<char>> Tokenizer;
-        std::vector<std::string> wordAndPoints;
-        //parse line
-        //insert to dataBase
-        Tokenizer tok(line);
-        wordAndPoints.assign(tok.begin(), tok.end());
-        //must check that the csv file has only two columns - else Invalid input\n
-        if (wordAndPoints.size() != 2 || wordAndPoints[0].size() < 1 || wordAndPoints[1].size() < 1 ||
-            !isNum(wordAndPoints[1]))
+        boost::filesystem::path dir = maildir / sub;
+        if (!boost::filesystem::is_directory(dir))
         {
-            throw hashExceptions("invalid input");
+            continue;
         }
-        _bad_words.insert(wordAndPoints[0], wordAndPoints[1]);
-    }
-
-    /**
-     * adds each bad_phrase to hashMap
-     * @param badWordsFile
-     */
-    void loadDataBase(std::ifstream &badWordsFile)
-    {
-        while (!badWordsFile.eof())
+        for (boost::filesystem::directory_iterator it(dir), end; it != end; ++it)
         {
-            //check if file is empty
-            if (badWordsFile.peek() == std::ifstream::traits_type::eof())
-            {
-                break;
-            }
-            std::string line;
-            getline(badWordsFile, line);
-            if (line.empty() && firstLine())
+            if (boost::filesystem::is_regular_file(it->status()))
             {
-                throw hashExceptions("first line empty");
+                paths.push_back(it->path().string());
             }
-            if (line.empty() && !firstLine())
-            {
-                continue;
-            }
-            _firstLine = false;
-            fromFileToHash(line);
         }
-        badWordsFile.close();
     }
-
-    /**
-     * make msg file one long string
-     * @param msgFile
-     */
-    void loadMessage(std::ifstream &msgFile)
+    for (boost::filesystem::directory_iterator it(maildir), end; it != end; ++it)
     {
-        while (!msgFile.eof())
+        std::string name = it->path().filename().string();
+        if (name.size() > 1 && name[0] == '.' && boost::filesystem::is_directory(it->status()))
         {
-            std::string s;
-            std::string space = "\n";
-
-            getline(msgFile, s);
-            setMsg(s);
-            setMsg(space);
+            maildirMessages(it->path(), paths);
         }
-        msgFile.close();
     }
+}
 
-    /**
-     * for each phrase in the HashMap, check if it is in the msg
-     */
-    void calculateSpam()
+/**
+ * scores every file of a spool directory or a maildir, reading the next files while the current one is scored
+ * @param spamDetector a detector with a loaded database
+ * @param spool
+ * @param inFlight the number of files read at once
+ * @param writer gets the results in the order of the file names
+ * @return EXIT_FAILURE if some file couldn't be read
+ */
+int scoreSpool(SpamDetector &spamDetector, const std::string &spool, unsigned int inFlight, ResultWriter &writer)
+{
+    std::vector<std::string> paths;
+    if (boost::filesystem::is_directory(boost::filesystem::path(spool) / "cur") &&
+        boost::filesystem::is_directory(boost::filesystem::path(spool) / "new"))
+    {
+        maildirMessages(spool, paths);
+    }
+    else
     {
-        _badPoints = 0;
-        transform(_msg.begin(), _msg.end(), _msg.begin(), ::tolower);
-        for (auto it = _bad_words.begin(); it != _bad_words.end(); ++it)
+        for (boost::filesystem::directory_iterator it(spool), end; it != end; ++it)
         {
-            std::string s = it->first;
-            transform(s.begin(), s.end(), s.begin(), ::tolower);
-            int times = 0;
-            unsigned int indexInMsg = _msg.find(s, 0);
-
-            while (indexInMsg != (unsigned int) std::string::npos)
+            if (boost::filesystem::is_regular_file(it->status()))
             {
-                times++;
-                indexInMsg = _msg.find(s, indexInMsg + s.size());
+                paths.push_back(it->path().string());
             }
-            int points = std::stoi(it->second);
-            setBadPoints(points * (times));
         }
-
     }
-
-    /**
-     * writes to std::cout the state of the ]msg
-     */
-    void dedection()
+    std::sort(paths.begin(), paths.end());
+    int result = 0;
+    auto score = [&](size_t index, std::string &content, bool ok)
     {
-        if (getBadPoints() >= getThreshold())
-        {
-            std::cout << SPAM_MESSAGE << std::endl;
-        }
-        else
+        if (!ok)
         {
-            std::cout << NOT_SPAM_MESSAGE << std::endl;
+            std::cerr << paths[index] << ": " << INVALID << std::endl;
+            writer.skip(index);
+            result = EXIT_FAILURE;
+            return;
         }
-    }
-
-    /**
-     *
-     * @return
-     */
-    HashMap<std::string, std::string> &getBadWords()
-    {
-        return _bad_words;
-    }
-
-    /**
-     *
-     * @return
-     */
-    std::string getMsg()
-    {
-        return _msg;
-    }
-
-    /**
-     *
-     * @return
-     */
-    double getThreshold()
-    {
-        return _threshold;
-    }
-
-    /**
-     *
-     * @param i
-     */
-    void setThreshold(int i)
-    {
-        _threshold = i;
-    }
-
-    /**
-     *
-     * @return
-     */
-    double getBadPoints()
-    {
-        return _badPoints;
-    }
-
-    /**
-     *
-     * @return
-     */
-    bool firstLine()
-    {
-        return _firstLine;
-    }
-
-    /**
-     *
-     * @param i
-     */
-    void setBadPoints(double i)
-    {
-        _badPoints += i;
-    }
-
-    /**
-     *
-     * @param s
-     */
-    void setMsg(std::string &s)
-    {
-        _msg += s;
-    }
+        spamDetector.scoreMessage(content.data(), content.size());
+        writer.write(index, spamDetector.result(paths[index]));
+    };
+    BatchReader reader(paths, inFlight);
+    reader.run(score);
+    return result;
+}
 
-    /**
-     *
-     * @param string
-     * @return
-     */
-    static bool isNum(const std::string &string)
+/**
+ * scores every message of an mbox while streaming through it, each result is labeled <mbox>:<offset>
+ * @param spamDetector a detector with a loaded database
+ * @param mailbox
+ * @param name
+ * @param writer
+ */
+void scoreMailbox(SpamDetector &spamDetector, std::istream &mailbox, const std::string &name, ResultWriter &writer)
+{
+    MailboxReader reader(mailbox);
+    std::string message;
+    unsigned long long offset;
+    for (size_t sequence = 0; reader.next(message, offset); ++sequence)
     {
-        auto it = string.begin();
-        while (it != string.end() && std::isdigit(*it))
-        {
-            ++it;
-        }
-        return !string.empty() && it == string.end();
+        spamDetector.scoreMessage(message.data(), message.size());
+        writer.write(sequence, spamDetector.result(name + ":" + std::to_string(offset)));
     }
-};
+}
 
 /**
  *
@@ -239,11 +131,63 @@ int main(int argc, char **argv)
 {
     try
     {
-        if (argc != 4)
+        if (argc < 4)
         {
             std::cerr << WRONG_NUMBER_OF_PARAMETERS << std::endl;
             return EXIT_FAILURE;
         }
+        bool stats = false;
+        bool mbox = false;
+        bool json = false;
+        std::string engine = AUTO_ENGINE;
+        unsigned int inFlight = DEFAULT_IN_FLIGHT;
+        size_t parallelThreshold = DEFAULT_PARALLEL_THRESHOLD;
+        size_t cacheEntries = DEFAULT_CACHE_ENTRIES;
+        for (int i = 4; i < argc; ++i)
+        {
+            std::string option = argv[i];
+            if (option == STATS_OPTION)
+            {
+                stats = true;
+            }
+            else if (option == MBOX_OPTION)
+            {
+                mbox = true;
+            }
+            else if (option.compare(0, strlen(ENGINE_OPTION), ENGINE_OPTION) == 0 &&
+                     MatcherFactory::isEngine(option.substr(strlen(ENGINE_OPTION))))
+            {
+                engine = option.substr(strlen(ENGINE_OPTION));
+            }
+            else if (option == std::string(FORMAT_OPTION) + PLAIN_FORMAT ||
+                     option == std::string(FORMAT_OPTION) + NDJSON_FORMAT)
+            {
+                json = option == std::string(FORMAT_OPTION) + NDJSON_FORMAT;
+            }
+            else if (option.compare(0, strlen(IN_FLIGHT_OPTION), IN_FLIGHT_OPTION) == 0 &&
+                     SpamDetector::isNum(option.substr(strlen(IN_FLIGHT_OPTION))) &&
+                     option.size() - strlen(IN_FLIGHT_OPTION) <= std::to_string(MAX_IN_FLIGHT).size() &&
+                     std::stoi(option.substr(strlen(IN_FLIGHT_OPTION))) >= 1 &&
+                     std::stoi(option.substr(strlen(IN_FLIGHT_OPTION))) <= MAX_IN_FLIGHT)
+            {
+                inFlight = std::stoi(option.substr(strlen(IN_FLIGHT_OPTION)));
+            }
+            else if (option.compare(0, strlen(PARALLEL_THRESHOLD_OPTION), PARALLEL_THRESHOLD_OPTION) == 0 &&
+                     SpamDetector::isNum(option.substr(strlen(PARALLEL_THRESHOLD_OPTION))))
+            {
+                parallelThreshold = std::stoull(option.substr(strlen(PARALLEL_THRESHOLD_OPTION)));
+            }
+            else if (option.compare(0, strlen(CACHE_OPTION), CACHE_OPTION) == 0 &&
+                     SpamDetector::isNum(option.substr(strlen(CACHE_OPTION))))
+            {
+                cacheEntries = std::stoull(option.substr(strlen(CACHE_OPTION)));
+            }
+            else
+            {
+                std::cerr << WRONG_NUMBER_OF_PARAMETERS << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
         std::string thresholdS = argv[3];
         if (!SpamDetector::isNum(thresholdS))
         {
@@ -256,31 +200,83 @@ int main(int argc, char **argv)
             std::cerr << INVALID << std::endl;
             return EXIT_FAILURE;
         }
+        ResultWriter writer(std::cout, json);
+        // a single message is labeled by its path only in ndjson, the plain output stays a bare verdict
+        std::string id = json ? argv[2] : "";
         std::ifstream msgFile;
         std::string msg = " ";
         std::ifstream badWordsFile;
-        badWordsFile.open(argv[1], std::fstream::in);
-        msgFile.open(argv[2], std::fstream::in);
-        if (msgFile.peek() == std::ifstream::traits_type::eof())
+        bool embedded = false;
+#ifdef USE_EMBEDDED_DICTIONARY
+        embedded = std::string(argv[1]) == EMBEDDED_DATABASE;
+#endif
+        if (!embedded)
         {
-            std::cout << NOT_SPAM_MESSAGE << std::endl;
-            return 0;
+            badWordsFile.open(argv[1], std::fstream::in);
+        }
+        bool standardInput = mbox && std::string(argv[2]) == STANDARD_INPUT;
+        bool spool = !mbox && boost::filesystem::is_directory(argv[2]);
+        if (mbox && !standardInput)
+        {
+            msgFile.open(argv[2], std::fstream::in | std::fstream::binary);
         }
-        if (!badWordsFile.is_open() || !msgFile.is_open())
+        else if (!spool && !mbox)
+        {
+            msgFile.open(argv[2], std::fstream::in);
+            if (msgFile.peek() == std::ifstream::traits_type::eof())
+            {
+                writer.write(0, Result{id, 0, false, 0});
+                return 0;
+            }
+        }
+        if ((!embedded && !badWordsFile.is_open()) || (!spool && !standardInput && !msgFile.is_open()))
         {
             std::cerr << INVALID << std::endl;
             return EXIT_FAILURE;
         }
-        if (badWordsFile.peek() == std::ifstream::traits_type::eof())
+        // an empty database makes no message spam - a single message is answered at once, the messages of a spool
+        // or a mailbox are still listed, with nothing to search for
+        bool emptyDatabase = !embedded && badWordsFile.peek() == std::ifstream::traits_type::eof();
+        if (emptyDatabase && !spool && !mbox)
         {
-            std::cout << NOT_SPAM_MESSAGE << std::endl;
+            writer.write(0, Result{id, 0, false, 0});
             return 0;
         }
         SpamDetector spamDetector(threshold, 0, msg);
-        spamDetector.loadDataBase(badWordsFile);
-        spamDetector.loadMessage(msgFile);
-        spamDetector.calculateSpam();
-        spamDetector.dedection();
+        spamDetector.setEngine(engine);
+        spamDetector.setParallelThreshold(parallelThreshold);
+        spamDetector.setCacheSize(cacheEntries);
+#ifdef USE_EMBEDDED_DICTIONARY
+        if (embedded)
+        {
+            spamDetector.loadEmbeddedDataBase();
+        }
+#endif
+        if (!embedded && !emptyDatabase)
+        {
+            spamDetector.loadDataBase(badWordsFile);
+        }
+        int result = 0;
+        if (spool)
+        {
+            result = scoreSpool(spamDetector, argv[2], inFlight, writer);
+        }
+        else if (mbox)
+        {
+            scoreMailbox(spamDetector, standardInput ? std::cin : msgFile, argv[2], writer);
+        }
+        else
+        {
+            spamDetector.loadMessage(msgFile);
+            spamDetector.calculateSpam();
+            writer.write(0, spamDetector.result(id));
+        }
+        writer.flush();
+        if (stats)
+        {
+            spamDetector.printStats();
+        }
+        return result;
     }
     catch (const hashExceptions &h)
     {
@@ -292,4 +288,3 @@ int main(int argc, char **argv)
         return EXIT_FAILURE;
     }
 }
-
@@ -0,0 +1,509 @@
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <boost/tokenizer.hpp>
+#include "HashMap.hpp"
+#include "MatcherFactory.hpp"
+#include "MessageScanner.hpp"
+#include "ParallelScanner.hpp"
+#include "ResultWriter.hpp"
+#include "VerdictCache.hpp"
+#ifdef USE_EMBEDDED_DICTIONARY
+#include "EmbeddedBadWords.hpp"
+#endif
+
+#ifndef SPAMDETECTOR
+#define SPAMDETECTOR
+
+/**
+ *
+ */
+class SpamDetector
+{
+private:
+    std::string _msg;
+    HashMap<std::string, std::string> _bad_words;
+    double _threshold;
+    double _badPoints;
+    int _matches = 0;
+    bool _firstLine = true;
+    bool _embedded = false;
+    std::string _engine = AUTO_ENGINE;
+    // the lower case phrases while the matcher is built, then only their weights
+    std::vector<Phrase> _phrases;
+    std::vector<PhraseWeight> _weights;
+    size_t _maxLength = 0;
+    std::unique_ptr<Matcher> _matcher;
+    ParallelScanner _scanner;
+    // changes whenever the matcher is rebuilt, the cache digests are seeded with it
+    uint64_t _version = 0;
+    VerdictCache _cache;
+public:
+    /**
+     *
+     * @param threshold
+     * @param points
+     * @param msg
+     */
+    SpamDetector(double threshold, double points, std::string &msg) : _msg(msg), _threshold(threshold),
+                                                                      _badPoints(points)
+    {
+        _bad_words = HashMap<std::string, std::string>();
+    }
+
+    /**
+     *
+     * @param line
+     */
+    void fromFileToHash(std::string &line)
+    {
+        typedef boost::tokenizer<boost::escaped_list_separator<char>> Tokenizer;
+        std::vector<std::string> wordAndPoints;
+        //parse line
+        //insert to dataBase
+        Tokenizer tok(line);
+        wordAndPoints.assign(tok.begin(), tok.end());
+        //must check that the csv file has only two columns - else Invalid input\n
+        if (wordAndPoints.size() != 2 || wordAndPoints[0].size() < 1 || wordAndPoints[1].size() < 1 ||
+            !isNum(wordAndPoints[1]))
+        {
+            throw hashExceptions("invalid input");
+        }
+        _bad_words.insert(wordAndPoints[0], wordAndPoints[1]);
+    }
+
+    /**
+     * adds each bad_phrase to hashMap and builds the matcher for them
+     * @param badWordsFile a database file, or any stream of its lines
+     */
+    void loadDataBase(std::istream &badWordsFile)
+    {
+        readDataBase(badWordsFile);
+        compile();
+    }
+
+    /**
+     * adds each bad_phrase to hashMap, without building anything
+     * @param badWordsFile a database file, or any stream of its lines
+     */
+    void readDataBase(std::istream &badWordsFile)
+    {
+        while (!badWordsFile.eof())
+        {
+            //check if file is empty
+            if (badWordsFile.peek() == std::ifstream::traits_type::eof())
+            {
+                break;
+            }
+            std::string line;
+            getline(badWordsFile, line);
+            if (line.empty() && firstLine())
+            {
+                throw hashExceptions("first line empty");
+            }
+            if (line.empty() && !firstLine())
+            {
+                continue;
+            }
+            _firstLine = false;
+            fromFileToHash(line);
+        }
+    }
+
+    /**
+     * the phrases compile would build the matcher from - DictionaryGenerator writes them into its header
+     * @return the lower case phrases of the database read so far, entries that only differ in case merged
+     */
+    std::vector<Phrase> phrases()
+    {
+        _phrases.clear();
+        collectPhrases();
+        std::vector<Phrase> phrases;
+        phrases.swap(_phrases);
+        return phrases;
+    }
+
+#ifdef USE_EMBEDDED_DICTIONARY
+
+    /**
+     * uses the bad words compiled into the binary (EmbeddedBadWords.hpp) instead of a database file
+     */
+    void loadEmbeddedDataBase()
+    {
+        _embedded = true;
+        compile();
+    }
+
+#endif
+
+    /**
+     * make msg file one long string
+     * @param msgFile
+     */
+    void loadMessage(std::ifstream &msgFile)
+    {
+        while (!msgFile.eof())
+        {
+            std::string s;
+            std::string space = "\n";
+
+            getline(msgFile, s);
+            setMsg(s);
+            setMsg(space);
+        }
+        msgFile.close();
+    }
+
+    /**
+     * replaces the msg with the content of a message file, the same string loadMessage builds from it
+     * @param data
+     * @param size
+     */
+    void setMessage(const char *data, size_t size)
+    {
+        _msg.assign(" ");
+        _msg.append(data, size);
+        _msg.push_back('\n');
+    }
+
+    /**
+     * scores one message of a batch
+     * @param data
+     * @param size
+     * @return true iff the message is spam, an empty message never is
+     */
+    bool scoreMessage(const char *data, size_t size)
+    {
+        if (size == 0)
+        {
+            _badPoints = 0;
+            _matches = 0;
+            return false;
+        }
+        setMessage(data, size);
+        calculateSpam();
+        return isSpam();
+    }
+
+    /**
+     * for each phrase in the HashMap, check if it is in the msg
+     */
+    void calculateSpam()
+    {
+        transform(_msg.begin(), _msg.end(), _msg.begin(), ::tolower);
+        if (_matcher == nullptr)
+        {
+            compile();
+        }
+        Digest digest{0, 0};
+        Verdict verdict{0, 0};
+        if (_cache.enabled())
+        {
+            digest = Digest::of(_msg.data(), _msg.size(), _version);
+            if (_cache.find(digest, verdict))
+            {
+                _badPoints = verdict.score;
+                _matches = verdict.matches;
+                return;
+            }
+        }
+        MatchCounter counter(_weights);
+        _scanner.scan(*_matcher, _maxLength, _msg.data(), _msg.size(), counter);
+        _badPoints = 0;
+        setBadPoints(counter.points());
+        _matches = counter.matches();
+        _cache.insert(digest, Verdict{_badPoints, _matches});
+    }
+
+    /**
+     * selects the search engine, takes effect when the database is loaded
+     * @param engine an engine name, "auto" or "calibrate"
+     */
+    void setEngine(const std::string &engine)
+    {
+        _engine = engine;
+    }
+
+    /**
+     * messages of at least threshold bytes are scanned in segments on every core
+     * @param threshold 0 scans every message on one thread
+     */
+    void setParallelThreshold(size_t threshold)
+    {
+        _scanner.setThreshold(threshold);
+    }
+
+    /**
+     * a scanner for a message that doesn't need to be copied into msg - it only reads the matcher, so many scanners
+     * may run at once on different threads
+     * @return a scanner of the loaded database
+     */
+    MessageScanner scanner() const
+    {
+        return MessageScanner(*_matcher, _weights, _maxLength);
+    }
+
+    /**
+     *
+     * @return changes whenever the matcher is rebuilt - verdicts cached with another version are of another
+     * dictionary
+     */
+    uint64_t version() const
+    {
+        return _version;
+    }
+
+    /**
+     *
+     * @param entries the number of verdicts cached by message content, 0 disables the cache
+     */
+    void setCacheSize(size_t entries)
+    {
+        _cache.setCapacity(entries);
+    }
+
+    /**
+     * builds the phrases from the database and the matcher for them - phrases that only differ in case count the
+     * same occurrences, so they become one phrase with the sum of their points. The database is released before the
+     * matcher is built, so its strings and the matcher's structures are never held at the same time.
+     */
+    void compile()
+    {
+        _phrases.clear();
+        collectPhrases();
+        // the phrases are all that is needed from here on
+        _bad_words = HashMap<std::string, std::string>();
+        releaseMemory();
+        _weights = PhraseWeight::of(_phrases);
+        _maxLength = DictionaryStats::of(_phrases).maxLength;
+        _matcher = MatcherFactory::build(_engine, _phrases);
+        // verdicts of the old dictionary can't be found anymore, and are dropped
+        static std::atomic<uint64_t> versions{0};
+        _version = ++versions;
+        _cache.clear();
+        // every matcher keeps its own copy of the phrases
+        std::vector<Phrase>().swap(_phrases);
+        releaseMemory();
+    }
+
+    /**
+     * writes to std::cerr the engine and how its searches went
+     */
+    void printStats() const
+    {
+        std::cerr << "phrases: " << _weights.size() << std::endl;
+        if (_matcher != nullptr)
+        {
+            std::cerr << "engine: " << _matcher->name() << std::endl;
+            _matcher->printStats(std::cerr);
+        }
+        std::cerr << "parallel scans: " << _scanner.parallelScans() << ", rescanned phrases: " << _scanner.rescans()
+                  << std::endl;
+        if (_cache.enabled())
+        {
+            unsigned long lookups = _cache.hits() + _cache.misses();
+            std::cerr << "cache hits: " << _cache.hits() << ", misses: " << _cache.misses() << ", hit rate: "
+                      << (lookups == 0 ? 0 : (double) _cache.hits() / lookups) << std::endl;
+        }
+    }
+
+    /**
+     * writes to std::cout the state of the ]msg
+     */
+    void dedection()
+    {
+        if (isSpam())
+        {
+            std::cout << SPAM_MESSAGE << std::endl;
+        }
+        else
+        {
+            std::cout << NOT_SPAM_MESSAGE << std::endl;
+        }
+    }
+
+    /**
+     *
+     * @param id
+     * @return the result of the last calculateSpam
+     */
+    Result result(const std::string &id)
+    {
+        return Result{id, getBadPoints(), isSpam(), getMatches()};
+    }
+
+    /**
+     *
+     * @return the number of bad phrase occurrences counted by the last calculateSpam
+     */
+    int getMatches() const
+    {
+        return _matches;
+    }
+
+    /**
+     *
+     * @return true iff the msg reached the threshold
+     */
+    bool isSpam()
+    {
+        return getBadPoints() >= getThreshold();
+    }
+
+    /**
+     *
+     * @return the database entries loaded since the last compile, compile releases them
+     */
+    HashMap<std::string, std::string> &getBadWords()
+    {
+        return _bad_words;
+    }
+
+    /**
+     *
+     * @return
+     */
+    std::string getMsg()
+    {
+        return _msg;
+    }
+
+    /**
+     *
+     * @return
+     */
+    double getThreshold()
+    {
+        return _threshold;
+    }
+
+    /**
+     *
+     * @param i
+     */
+    void setThreshold(int i)
+    {
+        _threshold = i;
+    }
+
+    /**
+     *
+     * @return
+     */
+    double getBadPoints()
+    {
+        return _badPoints;
+    }
+
+    /**
+     *
+     * @return
+     */
+    bool firstLine()
+    {
+        return _firstLine;
+    }
+
+    /**
+     *
+     * @param i
+     */
+    void setBadPoints(double i)
+    {
+        _badPoints += i;
+    }
+
+    /**
+     *
+     * @param s
+     */
+    void setMsg(std::string &s)
+    {
+        _msg += s;
+    }
+
+    /**
+     *
+     * @param string
+     * @return
+     */
+    static bool isNum(const std::string &string)
+    {
+        auto it = string.begin();
+        while (it != string.end() && std::isdigit(*it))
+        {
+            ++it;
+        }
+        return !string.empty() && it == string.end();
+    }
+
+private:
+    /**
+     * fills the phrases from the embedded table or from the loaded database
+     */
+    void collectPhrases()
+    {
+#ifdef USE_EMBEDDED_DICTIONARY
+        if (_embedded)
+        {
+            // the generator already lower-cased, parsed and merged the phrases
+            for (size_t i = 0; i < EMBEDDED_PHRASE_COUNT; ++i)
+            {
+                const EmbeddedPhrase &embedded = EMBEDDED_PHRASES[i];
+                _phrases.push_back(Phrase{std::string(embedded.phrase), embedded.points, embedded.entries});
+            }
+            return;
+        }
+#endif
+        // nothing to walk when no database was loaded
+        if (_bad_words.empty())
+        {
+            return;
+        }
+        HashMap<std::string, int> ids;
+        // end() walks the whole table, so it is taken once
+        auto end = _bad_words.end();
+        for (auto it = _bad_words.begin(); it != end; ++it)
+        {
+            std::string s = it->first;
+            transform(s.begin(), s.end(), s.begin(), ::tolower);
+            addPhrase(ids, s, std::stoi(it->second));
+        }
+    }
+
+    /**
+     * gives the freed heap back to the system
+     */
+    static void releaseMemory()
+    {
+#ifdef __GLIBC__
+        malloc_trim(0);
+#endif
+    }
+
+    /**
+     *
+     * @param ids the index of every phrase added so far
+     * @param phrase lower case phrase
+     * @param points
+     */
+    void addPhrase(HashMap<std::string, int> &ids, const std::string &phrase, int points)
+    {
+        if (ids.containsKey(phrase))
+        {
+            Phrase &known = _phrases[ids.at(phrase)];
+            known.points += points;
+            known.entries += 1;
+            return;
+        }
+        ids.insert(phrase, (int) _phrases.size());
+        _phrases.push_back(Phrase{phrase, points, 1});
+    }
+};
+
+#endif
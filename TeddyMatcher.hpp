@@ -0,0 +1,423 @@
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include "Matcher.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define TEDDY_AVX2
+#include <immintrin.h>
+#endif
+
+#ifndef TEDDYMATCHER
+#define TEDDYMATCHER
+
+#define TEDDY_BUCKETS 8
+#define TEDDY_MAX_FINGERPRINT 4
+#define TEDDY_BLOCK 32
+#define TEDDY_SEEN_BITS 18
+#define TEDDY_ASSIGN_ROUNDS 3
+#define TEDDY_ASSIGN_MAX 2048
+
+/**
+ * Teddy - the phrases are split into 8 buckets by their first 1-3 bytes, and each of these bytes gets a table
+ * of the buckets it may belong to, by its low nibble and by a second nibble - the high one, or bits 1-4 when that
+ * tells lower case letters apart better. A block of 32 text bytes is looked up in these tables with two shuffles
+ * per fingerprint byte, and the AND of the results leaves only the positions where some bucket matches all the
+ * fingerprint bytes. Only these candidates are confirmed against the phrases.
+ * The AVX2 path is chosen at runtime, CPUs without AVX2 use the same test one byte at a time.
+ */
+class TeddyMatcher : public Matcher
+{
+public:
+    /**
+     *
+     * @return
+     */
+    const char *name() const override
+    {
+        return "teddy";
+    }
+
+    /**
+     *
+     * @param phrases
+     */
+    void build(const std::vector<Phrase> &phrases) override
+    {
+        _phrases.clear();
+        _byFingerprint.clear();
+        _seen.assign((1 << TEDDY_SEEN_BITS) / 64, 0);
+        std::memset(_low, 0, sizeof(_low));
+        std::memset(_high, 0, sizeof(_high));
+        std::memset(_bytes, 0, sizeof(_bytes));
+        _fingerprint = TEDDY_MAX_FINGERPRINT;
+        for (const Phrase &phrase : phrases)
+        {
+            _phrases.push_back(phrase.text);
+            _fingerprint = std::min(_fingerprint, phrase.text.size());
+        }
+        if (_phrases.empty())
+        {
+            return;
+        }
+        for (size_t id = 0; id < _phrases.size(); ++id)
+        {
+            uint32_t fingerprint = fingerprintOf(_phrases[id].data());
+            _byFingerprint.emplace_back(fingerprint, (int) id);
+            _seen[seenIndex(fingerprint) / 64] |= 1ULL << (seenIndex(fingerprint) % 64);
+        }
+        std::sort(_byFingerprint.begin(), _byFingerprint.end());
+        std::vector<uint32_t> fingerprints;
+        for (const auto &entry : _byFingerprint)
+        {
+            if (fingerprints.empty() || fingerprints.back() != entry.first)
+            {
+                fingerprints.push_back(entry.first);
+            }
+        }
+        // the text is scanned lower case and is mostly made of the chars the phrases are made of, so their
+        // frequencies stand in for the text's
+        std::vector<size_t> counts(256, 0);
+        size_t total = 0;
+        for (const std::string &phrase : _phrases)
+        {
+            for (char c : phrase)
+            {
+                ++counts[(unsigned char) c];
+                ++total;
+            }
+        }
+        std::vector<std::pair<unsigned char, double>> frequencies;
+        for (int c = 0; c < 256; ++c)
+        {
+            if (counts[c] > 0)
+            {
+                frequencies.emplace_back((unsigned char) c, (double) counts[c] / total);
+            }
+        }
+        // the high nibble of a letter is 6 or 7 and tells almost nothing, bits 1-4 tell the letters apart
+        std::vector<uint8_t> buckets;
+        double bestRate = 0;
+        for (int shift : {4, 1})
+        {
+            std::vector<uint8_t> assignment;
+            double rate = _assign(fingerprints, shift, frequencies, assignment);
+            if (buckets.empty() || rate < bestRate)
+            {
+                buckets = std::move(assignment);
+                bestRate = rate;
+                _shift = shift;
+            }
+        }
+        for (size_t i = 0; i < fingerprints.size(); ++i)
+        {
+            for (size_t k = 0; k < _fingerprint; ++k)
+            {
+                unsigned char c = _byteOf(fingerprints[i], k);
+                _low[k][c & 0xf] |= 1 << buckets[i];
+                _high[k][(c >> _shift) & 0xf] |= 1 << buckets[i];
+            }
+        }
+        // the scalar path uses the same nibble test, folded into a table per byte value
+        for (size_t k = 0; k < _fingerprint; ++k)
+        {
+            for (int c = 0; c < 256; ++c)
+            {
+                _bytes[k][c] = _low[k][c & 0xf] & _high[k][(c >> _shift) & 0xf];
+            }
+        }
+    }
+
+    /**
+     *
+     * @param text
+     * @param size
+     * @param begin
+     * @param end
+     * @param counter
+     */
+    void scan(const char *text, size_t size, size_t begin, size_t end, MatchCounter &counter) const override
+    {
+        if (_phrases.empty())
+        {
+            return;
+        }
+        // a candidate needs all its fingerprint bytes inside the text
+        end = std::min(end, size - std::min(size, _fingerprint - 1));
+        unsigned long candidates = 0;
+        unsigned long confirmed = 0;
+        size_t i = begin;
+#ifdef TEDDY_AVX2
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        if (avx2)
+        {
+            i = _scanAvx2(text, size, begin, end, counter, candidates, confirmed);
+        }
+#endif
+        for (; i < end; ++i)
+        {
+            uint8_t bits = _bytes[0][(unsigned char) text[i]];
+            for (size_t k = 1; k < _fingerprint && bits; ++k)
+            {
+                bits &= _bytes[k][(unsigned char) text[i + k]];
+            }
+            if (bits)
+            {
+                ++candidates;
+                confirmed += _confirm(text, size, i, counter);
+            }
+        }
+        _candidates += candidates;
+        _confirmed += confirmed;
+    }
+
+    /**
+     *
+     * @param out
+     */
+    void printStats(std::ostream &out) const override
+    {
+        out << "fingerprint bytes: " << _fingerprint << ", second nibble from bit: " << _shift << std::endl;
+        out << "candidates: " << _candidates << ", confirmed: " << _confirmed << std::endl;
+    }
+
+    /**
+     *
+     */
+    void resetStats() override
+    {
+        _candidates = 0;
+        _confirmed = 0;
+    }
+
+private:
+    std::vector<std::string> _phrases;
+    // (fingerprint, id), sorted - a candidate's fingerprint finds the phrases to confirm
+    std::vector<std::pair<uint32_t, int>> _byFingerprint;
+    // a bit per hashed fingerprint, most candidates of the nibble test stop here
+    std::vector<uint64_t> _seen;
+    size_t _fingerprint = TEDDY_MAX_FINGERPRINT;
+    // the second nibble of a byte is (byte >> _shift) & 0xf
+    int _shift = 4;
+    alignas(16) uint8_t _low[TEDDY_MAX_FINGERPRINT][16];
+    alignas(16) uint8_t _high[TEDDY_MAX_FINGERPRINT][16];
+    uint8_t _bytes[TEDDY_MAX_FINGERPRINT][256];
+    mutable std::atomic<unsigned long> _candidates{0};
+    mutable std::atomic<unsigned long> _confirmed{0};
+
+    /**
+     *
+     * @param s at least _fingerprint bytes
+     * @return the fingerprint bytes as one number, ordered like the strings
+     */
+    uint32_t fingerprintOf(const char *s) const
+    {
+        uint32_t fingerprint = 0;
+        for (size_t k = 0; k < _fingerprint; ++k)
+        {
+            fingerprint = (fingerprint << 8) | (unsigned char) s[k];
+        }
+        return fingerprint;
+    }
+
+    /**
+     *
+     * @param fingerprint
+     * @param k
+     * @return the k-th byte of the fingerprint
+     */
+    unsigned char _byteOf(uint32_t fingerprint, size_t k) const
+    {
+        return (unsigned char) (fingerprint >> (8 * (_fingerprint - 1 - k)));
+    }
+
+    /**
+     * puts every fingerprint in the bucket where it lets the fewest text positions through - greedily, then moving
+     * each one again as long as that helps. A bucket lets a byte through when some fingerprint of it has its low
+     * nibble and some (maybe another) has its second nibble, and a position when all its fingerprint bytes pass.
+     * @param fingerprints distinct
+     * @param shift of the second nibble
+     * @param frequencies (byte, share of the text)
+     * @param buckets the bucket of each fingerprint
+     * @return the expected share of the positions that become candidates
+     */
+    double _assign(const std::vector<uint32_t> &fingerprints, int shift,
+                   const std::vector<std::pair<unsigned char, double>> &frequencies,
+                   std::vector<uint8_t> &buckets) const
+    {
+        if (fingerprints.size() > TEDDY_ASSIGN_MAX)
+        {
+            // every nibble table is about full whatever the assignment, the sorted fingerprints are just split up
+            buckets.resize(fingerprints.size());
+            for (size_t i = 0; i < fingerprints.size(); ++i)
+            {
+                buckets[i] = (uint8_t) (i * TEDDY_BUCKETS / fingerprints.size());
+            }
+            return 1;
+        }
+        // how many fingerprints of a bucket have each nibble at each fingerprint byte
+        uint32_t low[TEDDY_BUCKETS][TEDDY_MAX_FINGERPRINT][16] = {};
+        uint32_t high[TEDDY_BUCKETS][TEDDY_MAX_FINGERPRINT][16] = {};
+        auto count = [&](int bucket, uint32_t fingerprint, int delta)
+        {
+            for (size_t k = 0; k < _fingerprint; ++k)
+            {
+                unsigned char c = _byteOf(fingerprint, k);
+                low[bucket][k][c & 0xf] += delta;
+                high[bucket][k][(c >> shift) & 0xf] += delta;
+            }
+        };
+        // the share of the positions the bucket lets through, with the fingerprint added if with is set
+        auto rate = [&](int bucket, uint32_t fingerprint, bool with)
+        {
+            double rate = 1;
+            for (size_t k = 0; k < _fingerprint && rate > 0; ++k)
+            {
+                unsigned char own = _byteOf(fingerprint, k);
+                double passed = 0;
+                for (const auto &frequency : frequencies)
+                {
+                    unsigned char c = frequency.first;
+                    bool lowHit = low[bucket][k][c & 0xf] > 0 || (with && (own & 0xf) == (c & 0xf));
+                    bool highHit = high[bucket][k][(c >> shift) & 0xf] > 0 ||
+                                   (with && ((own >> shift) & 0xf) == ((c >> shift) & 0xf));
+                    passed += lowHit && highHit ? frequency.second : 0;
+                }
+                rate *= passed;
+            }
+            return rate;
+        };
+        buckets.assign(fingerprints.size(), TEDDY_BUCKETS);
+        for (int round = 0; round < TEDDY_ASSIGN_ROUNDS; ++round)
+        {
+            bool moved = false;
+            for (size_t i = 0; i < fingerprints.size(); ++i)
+            {
+                if (buckets[i] < TEDDY_BUCKETS)
+                {
+                    count(buckets[i], fingerprints[i], -1);
+                }
+                int best = 0;
+                double bestCost = 0;
+                for (int bucket = 0; bucket < TEDDY_BUCKETS; ++bucket)
+                {
+                    double cost = rate(bucket, fingerprints[i], true) - rate(bucket, fingerprints[i], false);
+                    if (bucket == 0 || cost < bestCost)
+                    {
+                        best = bucket;
+                        bestCost = cost;
+                    }
+                }
+                moved |= buckets[i] != best;
+                buckets[i] = (uint8_t) best;
+                count(best, fingerprints[i], 1);
+            }
+            if (!moved)
+            {
+                break;
+            }
+        }
+        double total = 0;
+        for (int bucket = 0; bucket < TEDDY_BUCKETS; ++bucket)
+        {
+            total += rate(bucket, 0, false);
+        }
+        return total;
+    }
+
+    /**
+     *
+     * @param fingerprint
+     * @return the bit of the fingerprint in _seen
+     */
+    static uint32_t seenIndex(uint32_t fingerprint)
+    {
+        return (fingerprint * 0x9e3779b1u) >> (32 - TEDDY_SEEN_BITS);
+    }
+
+    /**
+     * reports the phrases that really start at i
+     * @param text
+     * @param size
+     * @param i
+     * @param counter
+     * @return the number of phrases reported
+     */
+    int _confirm(const char *text, size_t size, size_t i, MatchCounter &counter) const
+    {
+        uint32_t fingerprint = fingerprintOf(text + i);
+        if (!(_seen[seenIndex(fingerprint) / 64] & (1ULL << (seenIndex(fingerprint) % 64))))
+        {
+            return 0;
+        }
+        auto it = std::lower_bound(_byFingerprint.begin(), _byFingerprint.end(), std::make_pair(fingerprint, 0));
+        int confirmed = 0;
+        for (; it != _byFingerprint.end() && it->first == fingerprint; ++it)
+        {
+            const std::string &phrase = _phrases[it->second];
+            if (phrase.size() <= size - i &&
+                std::memcmp(text + i + _fingerprint, phrase.data() + _fingerprint, phrase.size() - _fingerprint) == 0)
+            {
+                ++confirmed;
+                counter.report(it->second, i);
+            }
+        }
+        return confirmed;
+    }
+
+#ifdef TEDDY_AVX2
+
+    /**
+     * the vector path, 32 positions at a time
+     * @return the first position left for the scalar path
+     */
+    __attribute__((target("avx2")))
+    size_t _scanAvx2(const char *text, size_t size, size_t begin, size_t end, MatchCounter &counter,
+                     unsigned long &candidates, unsigned long &confirmed) const
+    {
+        __m256i nibble = _mm256_set1_epi8(0x0f);
+        // a 16 bit shift moves bits of the next byte in, the mask drops them again as long as the shift is at most 4
+        __m128i shift = _mm_cvtsi32_si128(_shift);
+        __m256i low[TEDDY_MAX_FINGERPRINT];
+        __m256i high[TEDDY_MAX_FINGERPRINT];
+        for (size_t k = 0; k < _fingerprint; ++k)
+        {
+            low[k] = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *) _low[k]));
+            high[k] = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *) _high[k]));
+        }
+        size_t i = begin;
+        // every load of the block must stay inside the text
+        for (; i < end && i + TEDDY_BLOCK + _fingerprint - 1 <= size; i += TEDDY_BLOCK)
+        {
+            __m256i result = _mm256_set1_epi8((char) 0xff);
+            for (size_t k = 0; k < _fingerprint; ++k)
+            {
+                __m256i v = _mm256_loadu_si256((const __m256i *) (text + i + k));
+                __m256i lo = _mm256_shuffle_epi8(low[k], _mm256_and_si256(v, nibble));
+                __m256i hi = _mm256_shuffle_epi8(high[k], _mm256_and_si256(_mm256_srl_epi16(v, shift), nibble));
+                result = _mm256_and_si256(result, _mm256_and_si256(lo, hi));
+            }
+            auto mask = (uint32_t) ~_mm256_movemask_epi8(_mm256_cmpeq_epi8(result, _mm256_setzero_si256()));
+            if (end - i < TEDDY_BLOCK)
+            {
+                mask &= (1u << (end - i)) - 1;
+            }
+            if (mask == 0)
+            {
+                continue;
+            }
+            while (mask)
+            {
+                int j = __builtin_ctz(mask);
+                mask &= mask - 1;
+                ++candidates;
+                confirmed += _confirm(text, size, i + j, counter);
+            }
+        }
+        return i;
+    }
+
+#endif
+};
+
+#endif
@@ -0,0 +1,60 @@
+#include <random>
+#include <string>
+#include <vector>
+#include "HashMap.hpp"
+#include "Matcher.hpp"
+
+#ifndef TESTDATA
+#define TESTDATA
+
+/**
+ * Random texts and dictionaries for the tests.
+ */
+class TestData
+{
+public:
+    /**
+     *
+     * @param random
+     * @param alphabet
+     * @param size
+     * @return size chars of the alphabet
+     */
+    static std::string text(std::mt19937 &random, const std::string &alphabet, size_t size)
+    {
+        std::string text;
+        for (size_t i = 0; i < size; ++i)
+        {
+            text += alphabet[random() % alphabet.size()];
+        }
+        return text;
+    }
+
+    /**
+     * different phrases of 1 to maxLength chars, worth 1 to 9 points and 1 or 2 entries - fewer than count if the
+     * alphabet doesn't have that many
+     * @param random
+     * @param alphabet
+     * @param count
+     * @param maxLength
+     * @return
+     */
+    static std::vector<Phrase> dictionary(std::mt19937 &random, const std::string &alphabet, size_t count,
+                                          size_t maxLength)
+    {
+        std::vector<Phrase> phrases;
+        HashMap<std::string, int> known;
+        for (size_t attempt = 0; phrases.size() < count && attempt < 20 * count; ++attempt)
+        {
+            std::string phrase = text(random, alphabet, 1 + random() % maxLength);
+            if (!known.containsKey(phrase))
+            {
+                known.insert(phrase, 0);
+                phrases.push_back(Phrase{phrase, 1 + (int) (random() % 9), 1 + (int) (random() % 2)});
+            }
+        }
+        return phrases;
+    }
+};
+
+#endif
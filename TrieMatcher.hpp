@@ -0,0 +1,85 @@
+#include "Matcher.hpp"
+#include "DoubleArrayTrie.hpp"
+
+#ifndef TRIEMATCHER
+#define TRIEMATCHER
+
+/**
+ * Walks the double-array trie of the phrases from every position of the text. The walk stops at the first char
+ * no phrase continues with, so it usually takes a step or two, whatever the size of the dictionary. The trie is
+ * the only copy of the phrases the matcher keeps.
+ */
+class TrieMatcher : public Matcher
+{
+public:
+    /**
+     *
+     * @return
+     */
+    const char *name() const override
+    {
+        return "trie";
+    }
+
+    /**
+     *
+     * @param phrases
+     */
+    void build(const std::vector<Phrase> &phrases) override
+    {
+        std::vector<std::string_view> keys;
+        std::vector<int> ids;
+        keys.reserve(phrases.size());
+        ids.reserve(phrases.size());
+        for (size_t id = 0; id < phrases.size(); ++id)
+        {
+            keys.push_back(phrases[id].text);
+            ids.push_back((int) id);
+        }
+        _trie.build(keys, ids);
+    }
+
+    /**
+     *
+     * @param text
+     * @param size
+     * @param begin
+     * @param end
+     * @param counter
+     */
+    void scan(const char *text, size_t size, size_t begin, size_t end, MatchCounter &counter) const override
+    {
+        size_t i = begin;
+        auto report = [&counter, &i](int id, size_t)
+        { counter.report(id, i); };
+        for (; i < end; ++i)
+        {
+            _trie.prefixes(text + i, size - i, report);
+        }
+    }
+
+    /**
+     *
+     * @param text lower case phrase
+     * @param size
+     * @return the id of the phrase, or -1
+     */
+    int find(const char *text, size_t size) const
+    {
+        return _trie.find(text, size);
+    }
+
+    /**
+     *
+     * @param out
+     */
+    void printStats(std::ostream &out) const override
+    {
+        out << "trie slots: " << _trie.slots() << ", bytes: " << _trie.bytes() << std::endl;
+    }
+
+private:
+    DoubleArrayTrie _trie;
+};
+
+#endif
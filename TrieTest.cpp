@@ -0,0 +1,135 @@
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "DoubleArrayTrie.hpp"
+
+/**
+ *
+ * @param random
+ * @param maxLength
+ * @param binary true for any byte, false for lower case letters
+ * @return a key of 1 to maxLength bytes
+ */
+std::string key(std::mt19937 &random, size_t maxLength, bool binary)
+{
+    std::string key;
+    size_t length = 1 + random() % maxLength;
+    for (size_t i = 0; i < length; ++i)
+    {
+        key += binary ? (char) (random() % 256) : (char) ('a' + random() % 26);
+    }
+    return key;
+}
+
+/**
+ * builds a trie of the keys of a map and checks every lookup and prefix walk against the map
+ * @param name
+ * @param keys
+ * @param random
+ * @param maxLength
+ * @param binary
+ * @return true iff the trie agrees with the map
+ */
+bool check(const std::string &name, const std::map<std::string, int> &keys, std::mt19937 &random, size_t maxLength,
+           bool binary)
+{
+    std::vector<std::string_view> views;
+    std::vector<int> values;
+    for (const auto &entry : keys)
+    {
+        views.push_back(entry.first);
+        values.push_back(entry.second);
+    }
+    // the build sorts the keys itself, so they are given in no order
+    std::vector<size_t> order(views.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), random);
+    std::vector<std::string_view> shuffledViews;
+    std::vector<int> shuffledValues;
+    for (size_t i : order)
+    {
+        shuffledViews.push_back(views[i]);
+        shuffledValues.push_back(values[i]);
+    }
+    DoubleArrayTrie trie;
+    trie.build(shuffledViews, shuffledValues);
+
+    for (const auto &entry : keys)
+    {
+        if (trie.find(entry.first.data(), entry.first.size()) != entry.second)
+        {
+            std::cerr << name << ": a key isn't found" << std::endl;
+            return false;
+        }
+    }
+    for (int probe = 0; probe < 20000; ++probe)
+    {
+        std::string text = key(random, maxLength + 4, binary);
+        auto known = keys.find(text);
+        if (trie.find(text.data(), text.size()) != (known == keys.end() ? -1 : known->second))
+        {
+            std::cerr << name << ": a lookup of a random string is wrong" << std::endl;
+            return false;
+        }
+        std::vector<std::pair<int, size_t>> expected;
+        for (size_t length = 1; length <= text.size(); ++length)
+        {
+            auto prefix = keys.find(text.substr(0, length));
+            if (prefix != keys.end())
+            {
+                expected.emplace_back(prefix->second, length);
+            }
+        }
+        std::vector<std::pair<int, size_t>> found;
+        auto visit = [&found](int value, size_t length)
+        { found.emplace_back(value, length); };
+        trie.prefixes(text.data(), text.size(), visit);
+        if (found != expected)
+        {
+            std::cerr << name << ": the prefixes of a random string are wrong" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ *
+ * @return
+ */
+int main()
+{
+    std::mt19937 random(33);
+    bool ok = true;
+
+    std::map<std::string, int> empty;
+    ok &= check("no keys", empty, random, 4, false);
+
+    // every key a prefix of the next one, and keys with the bytes 0 and 255
+    std::map<std::string, int> nested = {{"a", 0}, {"aa", 1}, {"aaa", 2}, {"aaaaaaaa", 3}, {"ab", 4},
+                                         {std::string(1, '\0'), 5}, {std::string("\0\xff", 2), 6},
+                                         {"\xff", 7}};
+    ok &= check("nested keys", nested, random, 8, true);
+
+    for (size_t count : {1, 10, 1000, 50000})
+    {
+        for (bool binary : {false, true})
+        {
+            std::map<std::string, int> keys;
+            while (keys.size() < count)
+            {
+                keys.emplace(key(random, binary ? 6 : 12, binary), (int) keys.size());
+            }
+            ok &= check(std::to_string(count) + (binary ? " binary keys" : " keys"), keys, random,
+                        binary ? 6 : 12, binary);
+        }
+    }
+    std::cout << (ok ? "passed" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,287 @@
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include "HashMap.hpp"
+
+#ifndef VERDICTCACHE
+#define VERDICTCACHE
+
+#define DEFAULT_CACHE_ENTRIES 4096
+#define CACHE_SHARDS 16
+
+/**
+ * a 128 bit content hash
+ */
+struct Digest
+{
+    uint64_t low;
+    uint64_t high;
+
+    /**
+     *
+     * @param other
+     * @return
+     */
+    bool operator==(const Digest &other) const
+    {
+        return low == other.low && high == other.high;
+    }
+
+    /**
+     * MurmurHash3 x64 128
+     * @param data
+     * @param size
+     * @param seed
+     * @return
+     */
+    static Digest of(const char *data, size_t size, uint64_t seed)
+    {
+        const uint64_t c1 = 0x87c37b91114253d5ULL;
+        const uint64_t c2 = 0x4cf5ad432745937fULL;
+        uint64_t h1 = seed;
+        uint64_t h2 = seed;
+        size_t blocks = size / 16;
+        for (size_t i = 0; i < blocks; ++i)
+        {
+            uint64_t k1;
+            uint64_t k2;
+            std::memcpy(&k1, data + i * 16, 8);
+            std::memcpy(&k2, data + i * 16 + 8, 8);
+            h1 ^= rotl(k1 * c1, 31) * c2;
+            h1 = (rotl(h1, 27) + h2) * 5 + 0x52dce729;
+            h2 ^= rotl(k2 * c2, 33) * c1;
+            h2 = (rotl(h2, 31) + h1) * 5 + 0x38495ab5;
+        }
+        const auto *tail = (const unsigned char *) data + blocks * 16;
+        uint64_t k1 = 0;
+        uint64_t k2 = 0;
+        switch (size & 15)
+        {
+            case 15: k2 ^= (uint64_t) tail[14] << 48; // fall through
+            case 14: k2 ^= (uint64_t) tail[13] << 40; // fall through
+            case 13: k2 ^= (uint64_t) tail[12] << 32; // fall through
+            case 12: k2 ^= (uint64_t) tail[11] << 24; // fall through
+            case 11: k2 ^= (uint64_t) tail[10] << 16; // fall through
+            case 10: k2 ^= (uint64_t) tail[9] << 8; // fall through
+            case 9: k2 ^= (uint64_t) tail[8];
+                h2 ^= rotl(k2 * c2, 33) * c1; // fall through
+            case 8: k1 ^= (uint64_t) tail[7] << 56; // fall through
+            case 7: k1 ^= (uint64_t) tail[6] << 48; // fall through
+            case 6: k1 ^= (uint64_t) tail[5] << 40; // fall through
+            case 5: k1 ^= (uint64_t) tail[4] << 32; // fall through
+            case 4: k1 ^= (uint64_t) tail[3] << 24; // fall through
+            case 3: k1 ^= (uint64_t) tail[2] << 16; // fall through
+            case 2: k1 ^= (uint64_t) tail[1] << 8; // fall through
+            case 1: k1 ^= (uint64_t) tail[0];
+                h1 ^= rotl(k1 * c1, 31) * c2;
+            default: break;
+        }
+        h1 ^= size;
+        h2 ^= size;
+        h1 += h2;
+        h2 += h1;
+        h1 = mix(h1);
+        h2 = mix(h2);
+        h1 += h2;
+        h2 += h1;
+        return Digest{h1, h2};
+    }
+
+private:
+    /**
+     *
+     * @param x
+     * @param r
+     * @return
+     */
+    static uint64_t rotl(uint64_t x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    /**
+     * the finalizer of MurmurHash3
+     * @param k
+     * @return
+     */
+    static uint64_t mix(uint64_t k)
+    {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+};
+
+/**
+ * the part of a result that only depends on the message and the dictionary
+ */
+struct Verdict
+{
+    double score;
+    int matches;
+};
+
+/**
+ * An LRU cache of verdicts by the digest of the lower case message. The caller seeds the digest with the
+ * dictionary version, so a verdict of another dictionary is never found. The entries are split into shards by
+ * digest, each with its own lock, so threads scoring different messages rarely wait for each other.
+ */
+class VerdictCache
+{
+public:
+    /**
+     *
+     * @param entries the number of verdicts kept, 0 disables the cache
+     */
+    explicit VerdictCache(size_t entries = DEFAULT_CACHE_ENTRIES)
+    {
+        setCapacity(entries);
+    }
+
+    /**
+     * drops every verdict
+     * @param entries the number of verdicts kept from now on, 0 disables the cache
+     */
+    void setCapacity(size_t entries)
+    {
+        _perShard = (entries + CACHE_SHARDS - 1) / CACHE_SHARDS;
+        clear();
+    }
+
+    /**
+     *
+     * @return false iff the cache is disabled
+     */
+    bool enabled() const
+    {
+        return _perShard > 0;
+    }
+
+    /**
+     *
+     * @param digest
+     * @param verdict set to the cached verdict on a hit
+     * @return true iff the verdict was cached
+     */
+    bool find(const Digest &digest, Verdict &verdict)
+    {
+        if (!enabled())
+        {
+            return false;
+        }
+        Shard &shard = shardOf(digest);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (!shard.index.containsKey(digest.low))
+        {
+            ++_misses;
+            return false;
+        }
+        auto it = shard.index.at(digest.low);
+        if (!(it->first == digest))
+        {
+            ++_misses;
+            return false;
+        }
+        // most recently used first
+        shard.entries.splice(shard.entries.begin(), shard.entries, it);
+        verdict = it->second;
+        ++_hits;
+        return true;
+    }
+
+    /**
+     *
+     * @param digest
+     * @param verdict
+     */
+    void insert(const Digest &digest, const Verdict &verdict)
+    {
+        if (!enabled())
+        {
+            return;
+        }
+        Shard &shard = shardOf(digest);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.index.containsKey(digest.low))
+        {
+            // the same message, or another one whose low half collides - the newer verdict wins
+            auto it = shard.index.at(digest.low);
+            *it = std::make_pair(digest, verdict);
+            shard.entries.splice(shard.entries.begin(), shard.entries, it);
+            return;
+        }
+        if (shard.entries.size() >= _perShard)
+        {
+            shard.index.erase(shard.entries.back().first.low);
+            shard.entries.pop_back();
+        }
+        shard.entries.emplace_front(digest, verdict);
+        shard.index.insert(digest.low, shard.entries.begin());
+    }
+
+    /**
+     * drops every verdict, the hit statistics are kept
+     */
+    void clear()
+    {
+        for (Shard &shard : _shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.entries.clear();
+            shard.index = HashMap<uint64_t, Iterator>();
+        }
+    }
+
+    /**
+     *
+     * @return
+     */
+    unsigned long hits() const
+    {
+        return _hits;
+    }
+
+    /**
+     *
+     * @return
+     */
+    unsigned long misses() const
+    {
+        return _misses;
+    }
+
+private:
+    typedef std::list<std::pair<Digest, Verdict>>::iterator Iterator;
+
+    /**
+     * a part of the cache with its own lock and LRU order
+     */
+    struct Shard
+    {
+        std::mutex mutex;
+        std::list<std::pair<Digest, Verdict>> entries;
+        HashMap<uint64_t, Iterator> index;
+    };
+
+    Shard _shards[CACHE_SHARDS];
+    size_t _perShard = 0;
+    std::atomic<unsigned long> _hits{0};
+    std::atomic<unsigned long> _misses{0};
+
+    /**
+     *
+     * @param digest
+     * @return
+     */
+    Shard &shardOf(const Digest &digest)
+    {
+        return _shards[digest.high % CACHE_SHARDS];
+    }
+};
+
+#endif